@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+
+enum class bind_kind { close, spread, master };
+
+struct tune_config {
+    omp_sched_t kind = omp_sched_static;
+    int chunk = 0;              // 0 - runtime default chunk
+    int threads = 1;
+    bind_kind bind = bind_kind::close;
+};
+
+inline std::string to_string(const tune_config &c) {
+    const char *kinds[] = {"", "static", "dynamic", "guided", "auto"};
+    const char *binds[] = {"close", "spread", "master"};
+    std::ostringstream out;
+    out << kinds[c.kind & 7] << "," << c.chunk << " threads " << c.threads
+        << " proc_bind " << binds[(int) c.bind];
+    return out.str();
+}
+
+// Runs body(i) for i in [0, n) with the schedule, thread count and
+// binding of the config. The schedule goes through omp_set_schedule,
+// proc_bind can only be given as a clause, hence one loop per binding.
+// The previous run-sched-var is restored, so later schedule(runtime)
+// loops still see the default schedule.
+template <typename F>
+void parallel_for_tuned(const tune_config &c, int n, F body) {
+    omp_sched_t saved_kind;
+    int saved_chunk;
+    omp_get_schedule(&saved_kind, &saved_chunk);
+    omp_set_schedule(c.kind, c.chunk);
+    switch (c.bind) {
+        case bind_kind::close:
+#pragma omp parallel for schedule(runtime) num_threads(c.threads) proc_bind(close)
+            for (int i = 0; i < n; ++i)
+                body(i);
+            break;
+        case bind_kind::spread:
+#pragma omp parallel for schedule(runtime) num_threads(c.threads) proc_bind(spread)
+            for (int i = 0; i < n; ++i)
+                body(i);
+            break;
+        case bind_kind::master:
+#pragma omp parallel for schedule(runtime) num_threads(c.threads) proc_bind(master)
+            for (int i = 0; i < n; ++i)
+                body(i);
+            break;
+    }
+    omp_set_schedule(saved_kind, saved_chunk);
+}
+
+// schedule kind x chunk x thread count x proc_bind; thread counts are
+// powers of two plus the maximum, which keeps the first round affordable.
+// Without a place list (OMP_PLACES / OMP_PROC_BIND) proc_bind has no
+// effect, so the binding is not searched then.
+inline std::vector<tune_config> search_space(int threads_max) {
+    std::vector<int> threads;
+    for (int t = 1; t < threads_max; t *= 2)
+        threads.push_back(t);
+    threads.push_back(threads_max);
+
+    std::vector<bind_kind> binds{bind_kind::close};
+    if (omp_get_num_places() > 0)
+        binds = {bind_kind::close, bind_kind::spread, bind_kind::master};
+
+    std::vector<tune_config> res;
+    for (auto kind : {omp_sched_static, omp_sched_dynamic, omp_sched_guided})
+        for (int chunk : {0, 1, 8, 64})
+            for (int t : threads)
+                for (auto bind : binds)
+                    res.push_back({kind, chunk, t, bind});
+    return res;
+}
+
+// Successive halving: every candidate gets one measurement, the best
+// third survives and gets twice as many, until one is left.
+inline tune_config successive_halving(std::vector<tune_config> candidates,
+                                      const std::function<double(const tune_config &)> &measure) {
+    int reps = 1;
+    while (candidates.size() > 1) {
+        std::vector<std::pair<double, int>> scores;
+        for (int i = 0; i < candidates.size(); ++i) {
+            double best = INFINITY;
+            for (int r = 0; r < reps; ++r)
+                best = std::min(best, measure(candidates[i]));
+            scores.emplace_back(best, i);
+        }
+        sort(scores.begin(), scores.end());
+
+        std::vector<tune_config> next;
+        int keep = std::max<int>(1, candidates.size() / 3);
+        for (int i = 0; i < keep; ++i)
+            next.push_back(candidates[scores[i].second]);
+        candidates = move(next);
+        reps *= 2;
+    }
+    return candidates.front();
+}
+
+// Winners are cached per host, kernel and power-of-two size bucket in
+// $TUNING_CACHE ("tuning.cache" by default), one per line:
+//   host  kernel  bucket  kind  chunk  threads  bind
+class tuning_cache {
+public:
+    tuning_cache() {
+        const char *env = std::getenv("TUNING_CACHE");
+        path = env ? env : "tuning.cache";
+        char name[256] = {};
+        gethostname(name, sizeof(name) - 1);
+        host = name;
+    }
+
+    static int bucket(long size) {
+        return size > 0 ? (int) std::log2((double) size) : 0;
+    }
+
+    bool find(const std::string &kernel, long size, tune_config &res) const {
+        std::ifstream in(path);
+        std::string line;
+        bool found = false;
+        while (getline(in, line)) {
+            std::istringstream fields(line);
+            std::string h, k;
+            int b, kind, chunk, threads, bind;
+            if (!(fields >> h >> k >> b >> kind >> chunk >> threads >> bind))
+                continue;
+            // later lines override earlier ones
+            if (h == host && k == kernel && b == bucket(size)) {
+                res = {(omp_sched_t) kind, chunk, threads, (bind_kind) bind};
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void store(const std::string &kernel, long size, const tune_config &c) const {
+        std::ofstream out(path, std::ios::app);
+        out << host << ' ' << kernel << ' ' << bucket(size) << ' ' << (int) c.kind << ' '
+            << c.chunk << ' ' << c.threads << ' ' << (int) c.bind << '\n';
+    }
+
+private:
+    std::string path;
+    std::string host;
+};
+
+// Returns the cached configuration for the kernel and size on this host,
+// searching for it (and caching the winner) on the first call
+inline tune_config autotune(const std::string &kernel, long size,
+                            const std::function<double(const tune_config &)> &measure) {
+    tuning_cache cache;
+    tune_config res;
+    if (cache.find(kernel, size, res))
+        return res;
+    res = successive_halving(search_space(omp_get_max_threads()), measure);
+    cache.store(kernel, size, res);
+    return res;
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "results_store.h"
+
+using namespace std;
+
+// Two-sided Mann-Whitney U test, normal approximation with tie correction
+double mann_whitney_p(const vector<double> &a, const vector<double> &b) {
+    int n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    if (n1 < 2 || n2 < 2)
+        return 1;
+
+    vector<pair<double, int>> all;
+    for (auto x : a)
+        all.emplace_back(x, 0);
+    for (auto x : b)
+        all.emplace_back(x, 1);
+    sort(all.begin(), all.end());
+
+    double rank_a = 0, ties = 0;
+    for (int i = 0; i < n;) {
+        int j = i;
+        while (j < n && all[j].first == all[i].first)
+            ++j;
+        double rank = (i + 1 + j) / 2.;
+        for (int k = i; k < j; ++k)
+            if (all[k].second == 0)
+                rank_a += rank;
+        double t = j - i;
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double u = rank_a - n1 * (n1 + 1) / 2.;
+    double mu = n1 * n2 / 2.;
+    double sigma = sqrt(n1 * n2 / 12. * ((n + 1) - ties / (n * (n - 1.))));
+    if (sigma == 0)
+        return 1;
+    double z = max(0., fabs(u - mu) - 0.5) / sigma;
+    return erfc(z / sqrt(2.));
+}
+
+// Smallest p the test can give for these sample counts, reached when
+// the two samples do not overlap at all
+double mann_whitney_min_p(int n1, int n2) {
+    if (n1 < 2 || n2 < 2)
+        return 1;
+    double sigma = sqrt(n1 * n2 * (n1 + n2 + 1) / 12.);
+    return erfc((n1 * n2 / 2. - 0.5) / sigma / sqrt(2.));
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        cerr << "usage: compare <baseline.tsv> <current.tsv> [threshold=0.05] [alpha=0.05]" << endl;
+        return 2;
+    }
+    double threshold = argc > 3 ? stod(argv[3]) : 0.05;
+    double alpha = argc > 4 ? stod(argv[4]) : 0.05;
+
+    map<record_key, run_record> baseline;
+    for (auto &r : load_run_file(argv[1]))
+        baseline[key_of(r)] = move(r);
+
+    int matched = 0, regressions = 0, improvements = 0, insufficient = 0;
+    cout << std::fixed << std::setprecision(6);
+    cout << "binary\tkernel\tsize\tthreads\tbaseline\tcurrent\tchange\tp\tverdict" << endl;
+    for (const auto &cur : load_run_file(argv[2])) {
+        auto it = baseline.find(key_of(cur));
+        if (it == baseline.end())
+            continue;
+        ++matched;
+        const auto &base = it->second;
+
+        double m_base = median(base.samples);
+        double m_cur = median(cur.samples);
+        double change = m_cur / m_base - 1;
+        double p = mann_whitney_p(base.samples, cur.samples);
+        // too few repetitions to ever be significant, a change there is not evidence either way
+        bool undecidable = mann_whitney_min_p(base.samples.size(), cur.samples.size()) >= alpha;
+        if (!undecidable && (p >= alpha || fabs(change) <= threshold))
+            continue;
+
+        string verdict = undecidable ? "insufficient samples" : change > 0 ? "REGRESSION" : "improvement";
+        (undecidable ? insufficient : change > 0 ? regressions : improvements)++;
+        cout << cur.binary << '\t' << cur.kernel << '\t' << cur.size << '\t' << cur.threads << '\t'
+             << m_base << '\t' << m_cur << '\t' << setprecision(1) << change * 100 << "%\t"
+             << setprecision(4) << p << '\t' << verdict << setprecision(6) << endl;
+    }
+
+    cout << endl;
+    cout << "matched " << matched << " of " << baseline.size() << " baseline records" << endl;
+    cout << "regressions " << regressions << endl;
+    cout << "improvements " << improvements << endl;
+    cout << "insufficient samples " << insufficient << endl;
+    if (regressions)
+        return 1;
+    return insufficient ? 3 : 0;
+}
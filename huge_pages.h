@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// system - whatever the kernel THP policy gives
+// small  - 4 KB pages only (MADV_NOHUGEPAGE)
+// thp    - transparent huge pages (MADV_HUGEPAGE)
+// huge2m - explicit 2 MB hugetlb pages, falls back to thp
+// huge1g - explicit 1 GB hugetlb pages, falls back to thp
+enum class page_mode { system, small, thp, huge2m, huge1g };
+
+inline page_mode parse_page_mode(const std::string &str) {
+    if (str == "4k")
+        return page_mode::small;
+    if (str == "thp")
+        return page_mode::thp;
+    if (str == "2m")
+        return page_mode::huge2m;
+    if (str == "1g")
+        return page_mode::huge1g;
+    return page_mode::system;
+}
+
+inline size_t page_size(page_mode mode) {
+    switch (mode) {
+        case page_mode::huge1g:
+            return size_t(1) << 30;
+        case page_mode::huge2m:
+        case page_mode::thp:
+            return size_t(1) << 21;
+        default:
+            return size_t(1) << 12;
+    }
+}
+
+// Allocator mapping every block directly with mmap, so the page size
+// of each buffer is under our control instead of malloc's. Pages are
+// faulted in by the first write, i.e. when a vector value-initializes
+// its elements, which happens outside of the timed regions.
+template <typename T>
+struct huge_page_allocator {
+    using value_type = T;
+
+    page_mode mode = page_mode::system;
+
+    huge_page_allocator() = default;
+    explicit huge_page_allocator(page_mode mode) : mode(mode) {}
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U> &other) : mode(other.mode) {}
+
+    T *allocate(size_t n) {
+        size_t bytes = round_up(n * sizeof(T));
+        void *p = MAP_FAILED;
+
+        if (mode == page_mode::huge2m || mode == page_mode::huge1g) {
+            int flags = mode == page_mode::huge2m ? MAP_HUGE_2MB : MAP_HUGE_1GB;
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flags, -1, 0);
+            if (p == MAP_FAILED)
+                std::cerr << "hugetlb pool exhausted, falling back to thp" << std::endl;
+        }
+        if (p == MAP_FAILED) {
+            p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+            if (mode == page_mode::small)
+                madvise(p, bytes, MADV_NOHUGEPAGE);
+            else if (mode != page_mode::system)
+                madvise(p, bytes, MADV_HUGEPAGE);
+        }
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, size_t n) {
+        munmap(p, round_up(n * sizeof(T)));
+    }
+
+    size_t round_up(size_t bytes) const {
+        size_t page = page_size(mode);
+        return (bytes + page - 1) / page * page;
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const huge_page_allocator<T> &a, const huge_page_allocator<U> &b) {
+    return a.mode == b.mode;
+}
+
+template <typename T, typename U>
+bool operator!=(const huge_page_allocator<T> &a, const huge_page_allocator<U> &b) {
+    return !(a == b);
+}
+
+struct memory_footprint {
+    long peak_rss_kb = 0;
+    long minor_faults = 0;
+    long major_faults = 0;
+    long rss_kb = 0;
+    long anon_huge_kb = 0;
+    long hugetlb_kb = 0;
+};
+
+inline memory_footprint footprint_now() {
+    memory_footprint res;
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    res.peak_rss_kb = usage.ru_maxrss;
+    res.minor_faults = usage.ru_minflt;
+    res.major_faults = usage.ru_majflt;
+
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string line;
+    while (getline(smaps, line)) {
+        std::istringstream in(line);
+        std::string key;
+        long kb = 0;
+        in >> key >> kb;
+        if (key == "Rss:")
+            res.rss_kb = kb;
+        else if (key == "AnonHugePages:")
+            res.anon_huge_kb = kb;
+        else if (key == "Private_Hugetlb:" || key == "Shared_Hugetlb:")
+            res.hugetlb_kb += kb;
+    }
+    return res;
+}
+
+// Prints the page faults taken between before and after together with
+// the peak RSS and the share of resident memory backed by huge pages.
+inline void print_footprint(const std::string &name, const memory_footprint &before, const memory_footprint &after) {
+    long resident = after.rss_kb + after.hugetlb_kb;
+    double coverage = resident ? double(after.anon_huge_kb + after.hugetlb_kb) / resident : 0;
+    std::cout << name
+              << " peak_rss_mb " << after.peak_rss_kb / 1024
+              << " minor_faults " << after.minor_faults - before.minor_faults
+              << " major_faults " << after.major_faults - before.major_faults
+              << " huge_page_coverage " << coverage << std::endl;
+}
+
+// Page faults taken inside one kernel, summed over all of its calls.
+// Only getrusage is read around a call, so it is cheap enough to wrap
+// every call of a sweep.
+struct kernel_footprint {
+    long minor_faults = 0;
+    long major_faults = 0;
+
+    template <typename Kernel>
+    double measure(Kernel kernel) {
+        rusage before{}, after{};
+        getrusage(RUSAGE_SELF, &before);
+        double time = kernel();
+        getrusage(RUSAGE_SELF, &after);
+        minor_faults += after.ru_minflt - before.ru_minflt;
+        major_faults += after.ru_majflt - before.ru_majflt;
+        return time;
+    }
+};
+
+inline void print_footprint(const std::string &name, const kernel_footprint &kernel) {
+    memory_footprint before, after = footprint_now();
+    after.minor_faults = kernel.minor_faults;
+    after.major_faults = kernel.major_faults;
+    print_footprint(name, before, after);
+}
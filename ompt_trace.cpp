@@ -0,0 +1,281 @@
+// OMPT tool linked into every benchmark. It stays inactive unless
+// $OMPT_TRACE names an output file; then it writes parallel regions,
+// implicit tasks, worksharing constructs and barrier / taskwait waits as
+// a Chrome / Perfetto trace, and prints busy vs wait time for every
+// thread. Lock, critical, atomic and ordered waits and chunk dispatches
+// can happen hundreds of millions of times per run, so they are only
+// aggregated per thread (count, total and longest wait).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <omp-tools.h>
+
+using namespace std;
+
+namespace {
+
+// a thread stops recording timeline events after this many (32 MB)
+const size_t max_events = 1 << 20;
+
+struct event {
+    const char *name;
+    char phase;             // 'B' begin, 'E' end
+    double ts;              // microseconds since the tool started
+    uint64_t arg;
+};
+
+enum wait_kind {
+    wait_barrier, wait_taskwait, wait_taskgroup, wait_reduction,
+    wait_critical, wait_atomic, wait_ordered, wait_lock, wait_kinds
+};
+
+const char *wait_names[wait_kinds] = {
+    "barrier", "taskwait", "taskgroup", "reduction", "critical", "atomic", "ordered", "lock"
+};
+
+struct wait_stats {
+    long count = 0;
+    double total = 0;
+    double longest = 0;
+};
+
+struct thread_trace {
+    int tid;
+    vector<event> events;
+    long dropped = 0;
+    // begin times of the implicit tasks this thread is in, nested regions push more
+    vector<double> task_begins;
+    // begin times of the barrier / taskwait waits this thread is in. Tasks
+    // run while waiting can wait themselves, only the outermost wait counts,
+    // minus the time the waiting task was switched out for other tasks.
+    vector<double> wait_begins;
+    ompt_data_t *waiting_task = nullptr;
+    double away_begin = 0;
+    double away = 0;
+    // lock waits never run other tasks, one slot is enough
+    double mutex_begin = 0;
+    double in_tasks = 0;
+    double waiting = 0;
+    wait_stats waits[wait_kinds];
+    long chunks = 0;
+};
+
+const char *output = nullptr;
+chrono::steady_clock::time_point start;
+// never destroyed: the runtime calls finalize after static destructors have run
+mutex &threads_mutex = *new mutex;
+vector<unique_ptr<thread_trace>> &threads = *new vector<unique_ptr<thread_trace>>;
+
+double now() {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// buffers are only touched by their own thread, the lock is taken once per thread
+thread_trace &local() {
+    thread_local thread_trace *trace = nullptr;
+    if (!trace) {
+        lock_guard guard(threads_mutex);
+        threads.push_back(make_unique<thread_trace>());
+        trace = threads.back().get();
+        trace->tid = threads.size() - 1;
+        trace->events.reserve(1 << 16);
+    }
+    return *trace;
+}
+
+void record(thread_trace &t, const char *name, char phase, double ts, uint64_t arg = 0) {
+    if (t.events.size() < max_events)
+        t.events.push_back({name, phase, ts, arg});
+    else
+        ++t.dropped;
+}
+
+void record(const char *name, char phase, uint64_t arg = 0) {
+    record(local(), name, phase, now(), arg);
+}
+
+wait_kind sync_kind(ompt_sync_region_t kind) {
+    switch (kind) {
+        case ompt_sync_region_taskwait:
+            return wait_taskwait;
+        case ompt_sync_region_taskgroup:
+            return wait_taskgroup;
+        case ompt_sync_region_reduction:
+            return wait_reduction;
+        default:
+            return wait_barrier;
+    }
+}
+
+wait_kind mutex_kind(ompt_mutex_t kind) {
+    switch (kind) {
+        case ompt_mutex_critical:
+            return wait_critical;
+        case ompt_mutex_atomic:
+            return wait_atomic;
+        case ompt_mutex_ordered:
+            return wait_ordered;
+        default:
+            return wait_lock;
+    }
+}
+
+const char *work_name(ompt_work_t kind) {
+    switch (kind) {
+        case ompt_work_loop:
+            return "loop";
+        case ompt_work_sections:
+            return "sections";
+        default:
+            return "work";
+    }
+}
+
+void add_wait(thread_trace &t, wait_kind kind, double wait) {
+    auto &stats = t.waits[kind];
+    ++stats.count;
+    stats.total += wait;
+    stats.longest = max(stats.longest, wait);
+    t.waiting += wait;
+}
+
+void on_parallel_begin(ompt_data_t *, const ompt_frame_t *, ompt_data_t *, unsigned int requested,
+                       int, const void *) {
+    record("parallel", 'B', requested);
+}
+
+void on_parallel_end(ompt_data_t *, ompt_data_t *, int, const void *) {
+    record("parallel", 'E');
+}
+
+void on_implicit_task(ompt_scope_endpoint_t endpoint, ompt_data_t *, ompt_data_t *,
+                      unsigned int, unsigned int index, int flags) {
+    if (flags & ompt_task_initial)
+        return;
+    auto &t = local();
+    double ts = now();
+    if (endpoint == ompt_scope_begin) {
+        t.task_begins.push_back(ts);
+        record(t, "implicit task", 'B', ts, index);
+    } else {
+        // time in nested tasks is already part of the outermost one
+        if (t.task_begins.size() == 1)
+            t.in_tasks += ts - t.task_begins.back();
+        if (!t.task_begins.empty())
+            t.task_begins.pop_back();
+        record(t, "implicit task", 'E', ts, index);
+    }
+}
+
+void on_sync_region_wait(ompt_sync_region_t kind, ompt_scope_endpoint_t endpoint, ompt_data_t *,
+                         ompt_data_t *task, const void *) {
+    auto &t = local();
+    double ts = now();
+    if (endpoint == ompt_scope_begin) {
+        if (t.wait_begins.empty()) {
+            t.waiting_task = task;
+            t.away = 0;
+        }
+        t.wait_begins.push_back(ts);
+        record(t, wait_names[sync_kind(kind)], 'B', ts);
+    } else {
+        if (t.wait_begins.size() == 1)
+            add_wait(t, sync_kind(kind), ts - t.wait_begins.back() - t.away);
+        if (!t.wait_begins.empty())
+            t.wait_begins.pop_back();
+        record(t, wait_names[sync_kind(kind)], 'E', ts);
+    }
+}
+
+// the runtime runs queued tasks inside barriers and taskwaits
+void on_task_schedule(ompt_data_t *prior, ompt_task_status_t, ompt_data_t *next) {
+    auto &t = local();
+    if (t.wait_begins.empty())
+        return;
+    if (prior == t.waiting_task)
+        t.away_begin = now();
+    else if (next == t.waiting_task)
+        t.away += now() - t.away_begin;
+}
+
+void on_mutex_acquire(ompt_mutex_t, unsigned int, unsigned int, ompt_wait_id_t, const void *) {
+    local().mutex_begin = now();
+}
+
+void on_mutex_acquired(ompt_mutex_t kind, ompt_wait_id_t, const void *) {
+    auto &t = local();
+    add_wait(t, mutex_kind(kind), now() - t.mutex_begin);
+}
+
+// single constructs are left out: libomp does not always report the end
+// of the executing thread's single, which unbalances the trace
+void on_work(ompt_work_t kind, ompt_scope_endpoint_t endpoint, ompt_data_t *, ompt_data_t *,
+             uint64_t count, const void *) {
+    if (kind == ompt_work_single_executor || kind == ompt_work_single_other)
+        return;
+    record(work_name(kind), endpoint == ompt_scope_begin ? 'B' : 'E', count);
+}
+
+void on_dispatch(ompt_data_t *, ompt_data_t *, ompt_dispatch_t, ompt_data_t) {
+    ++local().chunks;
+}
+
+int initialize(ompt_function_lookup_t lookup, int, ompt_data_t *) {
+    auto set_callback = (ompt_set_callback_t) lookup("ompt_set_callback");
+    set_callback(ompt_callback_parallel_begin, (ompt_callback_t) on_parallel_begin);
+    set_callback(ompt_callback_parallel_end, (ompt_callback_t) on_parallel_end);
+    set_callback(ompt_callback_implicit_task, (ompt_callback_t) on_implicit_task);
+    set_callback(ompt_callback_sync_region_wait, (ompt_callback_t) on_sync_region_wait);
+    set_callback(ompt_callback_task_schedule, (ompt_callback_t) on_task_schedule);
+    set_callback(ompt_callback_mutex_acquire, (ompt_callback_t) on_mutex_acquire);
+    set_callback(ompt_callback_mutex_acquired, (ompt_callback_t) on_mutex_acquired);
+    set_callback(ompt_callback_work, (ompt_callback_t) on_work);
+    set_callback(ompt_callback_dispatch, (ompt_callback_t) on_dispatch);
+    start = chrono::steady_clock::now();
+    return 1;
+}
+
+void finalize(ompt_data_t *) {
+    lock_guard guard(threads_mutex);
+
+    ofstream out(output);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (auto &t : threads)
+        for (auto &e : t->events) {
+            out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"" << e.phase
+                << "\",\"ts\":" << e.ts << ",\"pid\":0,\"tid\":" << t->tid
+                << ",\"args\":{\"value\":" << e.arg << "}}";
+            first = false;
+        }
+    out << "\n]}\n";
+
+    cout << "ompt trace " << output << endl << "thread\tbusy_ms\twait_ms\tchunks\tdropped_events" << endl;
+    cout << std::fixed << std::setprecision(3);
+    for (auto &t : threads)
+        cout << t->tid << '\t' << (t->in_tasks - t->waiting) / 1000 << '\t' << t->waiting / 1000 << '\t'
+             << t->chunks << '\t' << t->dropped << endl;
+    cout << "thread\twait\tcount\ttotal_ms\tmax_ms" << endl;
+    for (auto &t : threads)
+        for (int k = 0; k < wait_kinds; ++k)
+            if (t->waits[k].count)
+                cout << t->tid << '\t' << wait_names[k] << '\t' << t->waits[k].count << '\t'
+                     << t->waits[k].total / 1000 << '\t' << t->waits[k].longest / 1000 << endl;
+}
+
+}
+
+extern "C" ompt_start_tool_result_t *ompt_start_tool(unsigned int, const char *) {
+    static ompt_start_tool_result_t result{initialize, finalize, {0}};
+    output = getenv("OMPT_TRACE");
+    return output ? &result : nullptr;
+}
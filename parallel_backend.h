@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if __has_include(<execution>)
+#include <execution>
+#define PARALLEL_BACKEND_STD
+#if __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#define PARALLEL_BACKEND_TBB_CONTROL
+#endif
+#endif
+
+// static  - one contiguous chunk per thread
+// dynamic - chunks of `chunk` indices handed out on demand
+enum class schedule_kind { static_, dynamic };
+
+inline int chunk_count(int n, int threads, schedule_kind s, int chunk) {
+    if (s == schedule_kind::static_)
+        return threads;
+    return (n + chunk - 1) / chunk;
+}
+
+inline std::pair<int, int> chunk_range(int c, int n, int threads, schedule_kind s, int chunk) {
+    if (s == schedule_kind::static_)
+        return {(int) ((long long) n * c / threads), (int) ((long long) n * (c + 1) / threads)};
+    return {c * chunk, std::min(n, (c + 1) * chunk)};
+}
+
+// body(chunk, begin, end) is called once for every chunk of [0, n)
+using chunk_body = std::function<void(int, int, int)>;
+
+class parallel_backend {
+public:
+    virtual ~parallel_backend() = default;
+    virtual std::string name() const = 0;
+    // most threads a parallel_for really runs on, larger requests are clamped
+    virtual int max_threads() const { return INT_MAX; }
+    virtual void parallel_for(int n, int threads, schedule_kind s, int chunk, const chunk_body &body) = 0;
+    virtual void parallel_invoke(int threads, const std::vector<std::function<void()>> &tasks) = 0;
+};
+
+#ifdef _OPENMP
+class omp_backend : public parallel_backend {
+public:
+    std::string name() const override { return "omp"; }
+
+    void parallel_for(int n, int threads, schedule_kind s, int chunk, const chunk_body &body) override {
+        int chunks = chunk_count(n, threads, s, chunk);
+        if (s == schedule_kind::static_) {
+#pragma omp parallel for num_threads(threads) schedule(static, 1)
+            for (int c = 0; c < chunks; ++c) {
+                auto [begin, end] = chunk_range(c, n, threads, s, chunk);
+                body(c, begin, end);
+            }
+        } else {
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+            for (int c = 0; c < chunks; ++c) {
+                auto [begin, end] = chunk_range(c, n, threads, s, chunk);
+                body(c, begin, end);
+            }
+        }
+    }
+
+    void parallel_invoke(int threads, const std::vector<std::function<void()>> &tasks) override {
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+        for (int i = 0; i < tasks.size(); ++i)
+            tasks[i]();
+    }
+};
+#endif
+
+// Persistent workers, each parked on a futex of its own. The caller is
+// participant 0, publishes a job by bumping the generation of the workers
+// it needs and sleeps on `pending` until all of them have checked in, so
+// no worker can still be reading the previous job when the next one is
+// published. Workers past the requested thread count are not woken.
+class thread_pool_backend : public parallel_backend {
+public:
+    explicit thread_pool_backend(int threads_max) : slots(threads_max) {
+        for (int id = 1; id < threads_max; ++id)
+            workers.emplace_back([this, id] { worker(id); });
+    }
+
+    ~thread_pool_backend() override {
+        stop = true;
+        for (int id = 1; id <= workers.size(); ++id) {
+            slots[id].generation.fetch_add(1, std::memory_order_release);
+            futex_wake(slots[id].generation);
+        }
+        for (auto &w : workers)
+            w.join();
+    }
+
+    std::string name() const override { return "pool"; }
+
+    int max_threads() const override { return workers.size() + 1; }
+
+    void parallel_for(int n, int threads, schedule_kind s, int chunk, const chunk_body &body) override {
+        threads = std::min(threads, max_threads());
+        int chunks = chunk_count(n, threads, s, chunk);
+        std::atomic<int> next{0};
+        run(threads, [&](int id) {
+            if (s == schedule_kind::static_) {
+                auto [begin, end] = chunk_range(id, n, threads, s, chunk);
+                body(id, begin, end);
+                return;
+            }
+            for (int c; (c = next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+                auto [begin, end] = chunk_range(c, n, threads, s, chunk);
+                body(c, begin, end);
+            }
+        });
+    }
+
+    void parallel_invoke(int threads, const std::vector<std::function<void()>> &tasks) override {
+        std::atomic<int> next{0};
+        run(threads, [&](int) {
+            for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < tasks.size();)
+                tasks[i]();
+        });
+    }
+
+private:
+    struct alignas(64) slot {
+        std::atomic<int> generation{0};
+    };
+
+    static void futex_wait(std::atomic<int> &word, int expected) {
+        syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+
+    static void futex_wake(std::atomic<int> &word) {
+        syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    // spins for a short while before going to sleep in the kernel
+    static void wait_while_equal(std::atomic<int> &word, int value) {
+        for (int spin = 0; spin < 4096; ++spin)
+            if (word.load(std::memory_order_acquire) != value)
+                return;
+        while (word.load(std::memory_order_acquire) == value)
+            futex_wait(word, value);
+    }
+
+    void run(int threads, const std::function<void(int)> &f) {
+        threads = std::min(threads, max_threads());
+        job = &f;
+        pending.store(threads - 1, std::memory_order_relaxed);
+        for (int id = 1; id < threads; ++id) {
+            slots[id].generation.fetch_add(1, std::memory_order_release);
+            futex_wake(slots[id].generation);
+        }
+
+        f(0);
+        for (int p; (p = pending.load(std::memory_order_acquire)) != 0;)
+            wait_while_equal(pending, p);
+    }
+
+    void worker(int id) {
+        auto &generation = slots[id].generation;
+        int seen = 0;
+        while (true) {
+            wait_while_equal(generation, seen);
+            seen = generation.load(std::memory_order_acquire);
+            if (stop)
+                return;
+            (*job)(id);
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                futex_wake(pending);
+        }
+    }
+
+    std::vector<slot> slots;
+    std::vector<std::thread> workers;
+    alignas(64) std::atomic<int> pending{0};
+    const std::function<void(int)> *job = nullptr;
+    bool stop = false;
+};
+
+#ifdef PARALLEL_BACKEND_STD
+// C++17 parallel algorithms. The thread count can only be capped when
+// they run on top of TBB, otherwise the library decides.
+class std_backend : public parallel_backend {
+public:
+    std::string name() const override { return "std"; }
+
+    void parallel_for(int n, int threads, schedule_kind s, int chunk, const chunk_body &body) override {
+#ifdef PARALLEL_BACKEND_TBB_CONTROL
+        tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+#endif
+        std::vector<int> chunks(chunk_count(n, threads, s, chunk));
+        std::iota(chunks.begin(), chunks.end(), 0);
+        // par, not par_unseq: chunk bodies are arbitrary code and may allocate or lock
+        std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](int c) {
+            auto [begin, end] = chunk_range(c, n, threads, s, chunk);
+            body(c, begin, end);
+        });
+    }
+
+    void parallel_invoke(int threads, const std::vector<std::function<void()>> &tasks) override {
+#ifdef PARALLEL_BACKEND_TBB_CONTROL
+        tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+#endif
+        std::for_each(std::execution::par, tasks.begin(), tasks.end(), [](const auto &task) { task(); });
+    }
+};
+#endif
+
+// Reduces map(begin, end) over the chunks of [0, n); every chunk writes
+// its own cache line, the partials are combined on the calling thread
+template <typename T, typename Map, typename Op>
+T parallel_reduce(parallel_backend &backend, int n, int threads, T init, Map map, Op op,
+                  schedule_kind s = schedule_kind::static_, int chunk = 0) {
+    struct alignas(64) partial { T value; };
+    threads = std::min(threads, backend.max_threads());
+    std::vector<partial> partials(chunk_count(n, threads, s, chunk), partial{init});
+    backend.parallel_for(n, threads, s, chunk, [&](int c, int begin, int end) {
+        partials[c].value = map(begin, end);
+    });
+    T res = init;
+    for (const auto &p : partials)
+        res = op(res, p.value);
+    return res;
+}
+
+inline std::vector<std::unique_ptr<parallel_backend>> make_backends(const std::string &which, int threads_max) {
+    std::vector<std::unique_ptr<parallel_backend>> res;
+#ifdef _OPENMP
+    if (which == "all" || which == "omp")
+        res.push_back(std::make_unique<omp_backend>());
+#endif
+    if (which == "all" || which == "pool")
+        res.push_back(std::make_unique<thread_pool_backend>(threads_max));
+#ifdef PARALLEL_BACKEND_STD
+    if (which == "all" || which == "std")
+        res.push_back(std::make_unique<std_backend>());
+#endif
+    return res;
+}
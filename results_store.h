@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// One benchmark configuration and the times of all its repetitions
+struct run_record {
+    std::string binary;
+    std::string kernel;
+    long size = 0;
+    int threads = 0;
+    std::vector<double> samples;
+};
+
+using record_key = std::tuple<std::string, std::string, long, int>;
+
+inline record_key key_of(const run_record &r) {
+    return {r.binary, r.kernel, r.size, r.threads};
+}
+
+// Collects every repetition of a benchmark and writes them as one run file
+// <dir>/<binary>-<unix time>.tsv with a line per (kernel, size, threads):
+//   binary  kernel  size  threads  t1,t2,...
+// The directory is taken from $RESULTS_DIR, "results" by default.
+class results_store {
+public:
+    explicit results_store(std::string binary) : binary(std::move(binary)) {}
+
+    // Returns time, so it can wrap the call being measured
+    double add(const std::string &kernel, long size, int threads, double time) {
+        auto &r = records[{binary, kernel, size, threads}];
+        if (r.samples.empty()) {
+            r.binary = binary;
+            r.kernel = kernel;
+            r.size = size;
+            r.threads = threads;
+        }
+        r.samples.push_back(time);
+        return time;
+    }
+
+    std::string save() const {
+        const char *env = std::getenv("RESULTS_DIR");
+        std::filesystem::path dir = env ? env : "results";
+        std::filesystem::create_directories(dir);
+        auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        auto path = dir / (binary + "-" + std::to_string(stamp) + ".tsv");
+
+        std::ofstream out(path);
+        out.precision(9);
+        for (const auto &[key, r] : records) {
+            out << r.binary << '\t' << r.kernel << '\t' << r.size << '\t' << r.threads << '\t';
+            for (size_t i = 0; i < r.samples.size(); ++i)
+                out << (i ? "," : "") << r.samples[i];
+            out << '\n';
+        }
+        return path.string();
+    }
+
+private:
+    std::string binary;
+    std::map<record_key, run_record> records;
+};
+
+inline double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+inline std::vector<run_record> load_run_file(const std::string &path) {
+    std::vector<run_record> res;
+    std::ifstream in(path);
+    std::string line;
+    while (getline(in, line)) {
+        std::istringstream fields(line);
+        run_record r;
+        std::string samples;
+        if (!(fields >> r.binary >> r.kernel >> r.size >> r.threads >> samples))
+            continue;
+        std::istringstream values(samples);
+        std::string value;
+        while (getline(values, value, ','))
+            r.samples.push_back(std::stod(value));
+        res.push_back(std::move(r));
+    }
+    return res;
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "results_store.h"
+
+using namespace std;
+
+// threads -> median time of one (kernel, size)
+using curve = map<int, double>;
+
+// Amdahl: S(p) = 1 / (s + (1-s)/p), linear in s after
+// 1/S - 1/p = s (1 - 1/p)
+double fit_amdahl(const curve &c) {
+    double t1 = c.begin()->second, xy = 0, xx = 0;
+    for (auto [p, t] : c) {
+        double x = 1 - 1. / p, y = t / t1 - 1. / p;
+        xy += x * y;
+        xx += x * x;
+    }
+    return xx ? clamp(xy / xx, 0., 1.) : 1;
+}
+
+// Gustafson on weak scaling: p threads get p times the base size,
+// S(p) = p T(1, n) / T(p, p n) = p - a (p - 1)
+double fit_gustafson(const map<long, curve> &sizes, long &base) {
+    for (auto &[n, c] : sizes) {
+        if (c.empty() || c.begin()->first != 1)
+            continue;
+        double xy = 0, xx = 0;
+        int points = 0;
+        for (auto [p, t] : c) {
+            auto scaled = sizes.find(n * p);
+            if (p == 1 || scaled == sizes.end() || !scaled->second.count(p))
+                continue;
+            double s = p * c.begin()->second / scaled->second.at(p);
+            xy += (p - s) * (p - 1);
+            xx += (p - 1.) * (p - 1);
+            ++points;
+        }
+        if (points >= 2) {
+            base = n;
+            return clamp(xy / xx, 0., 1.);
+        }
+    }
+    base = 0;
+    return NAN;
+}
+
+// Universal Scalability Law: S(p) = p / (1 + sigma (p-1) + kappa p (p-1)),
+// least squares on p/S - 1 = sigma (p-1) + kappa p (p-1)
+pair<double, double> fit_usl(const curve &c) {
+    double t1 = c.begin()->second;
+    double aa = 0, ab = 0, bb = 0, ay = 0, by = 0;
+    for (auto [p, t] : c) {
+        double a = p - 1, b = p * (p - 1.), y = p * t / t1 - 1;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        ay += a * y;
+        by += b * y;
+    }
+    double det = aa * bb - ab * ab;
+    if (det == 0)
+        return {aa ? clamp(ay / aa, 0., 1.) : 0, 0};
+    double sigma = (ay * bb - by * ab) / det;
+    double kappa = (aa * by - ab * ay) / det;
+    // sigma is a serial fraction in [0, 1] and kappa cannot be negative;
+    // outside of that the other coefficient is refit with this one fixed
+    if (kappa < 0)
+        return {clamp(ay / aa, 0., 1.), 0};
+    if (sigma < 0 || sigma > 1) {
+        sigma = clamp(sigma, 0., 1.);
+        return {sigma, max(0., (by - sigma * ab) / bb)};
+    }
+    return {sigma, kappa};
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cerr << "usage: scaling <run.tsv>..." << endl;
+        return 2;
+    }
+
+    // (binary, kernel) -> size -> threads -> median time
+    map<pair<string, string>, map<long, curve>> curves;
+    for (int i = 1; i < argc; ++i)
+        for (auto &r : load_run_file(argv[i]))
+            curves[{r.binary, r.kernel}][r.size][r.threads] = median(r.samples);
+
+    cout << std::fixed << std::setprecision(4);
+    for (auto &[name, sizes] : curves) {
+        cout << name.first << " " << name.second << endl;
+
+        long pays_off = -1;
+        cout << "size\tamdahl_s\tusl_sigma\tusl_kappa\tp_opt" << endl;
+        for (auto &[n, c] : sizes) {
+            if (c.size() < 2 || c.begin()->first != 1)
+                continue;
+            double best = c.begin()->second;
+            for (auto [p, t] : c)
+                best = min(best, t);
+            if (pays_off < 0 && best < c.begin()->second)
+                pays_off = n;
+
+            auto [sigma, kappa] = fit_usl(c);
+            cout << n << '\t' << fit_amdahl(c) << '\t' << sigma << '\t' << kappa << '\t';
+            // USL peaks at sqrt((1 - sigma) / kappa), without coherency it never turns back
+            if (kappa > 0)
+                cout << max(1., sqrt((1 - sigma) / kappa)) << endl;
+            else
+                cout << "inf" << endl;
+        }
+
+        long base;
+        double alpha = fit_gustafson(sizes, base);
+        if (base)
+            cout << "gustafson serial fraction " << alpha << " (base size " << base << ")" << endl;
+        if (pays_off >= 0)
+            cout << "parallelism pays off from size " << pays_off << endl;
+        else
+            cout << "parallelism never pays off" << endl;
+
+        auto &[n, c] = *sizes.rbegin();
+        if (!c.empty() && c.begin()->first == 1) {
+            cout << "size " << n << endl << "threads\ttime\tspeedup\tefficiency" << endl;
+            for (auto [p, t] : c) {
+                double s = c.begin()->second / t;
+                cout << p << '\t' << t << '\t' << s << '\t' << s / p << endl;
+            }
+        }
+        cout << endl;
+    }
+    return 0;
+}
@@ -3,9 +3,13 @@
 #include <vector>
 #include <algorithm>
 #include <omp.h>
+#include "huge_pages.h"
+#include "results_store.h"
 using namespace std;
 
-double run(const vector<int> &data, int threads, int size) {
+using huge_vector = vector<int, huge_page_allocator<int>>;
+
+double run(const huge_vector &data, int threads, int size) {
     double time = omp_get_wtime();
     omp_set_num_threads(threads);
     vector maxes(threads, data[0]);
@@ -21,10 +25,13 @@ double run(const vector<int> &data, int threads, int size) {
 
 int main(int argc, char** argv) {
     int threads_max = omp_get_max_threads();
+    results_store store("task1");
     vector times(threads_max, vector(100, 0.));
 
-    auto vector_generator = [](int size) {
-        vector data(1'000'000'000, 0);
+    // task1 [system|4k|thp|2m|1g] selects the page size backing the data
+    page_mode mode = parse_page_mode(argc > 1 ? argv[1] : "system");
+    auto vector_generator = [mode](int size) {
+        huge_vector data(1'000'000'000, 0, huge_page_allocator<int>(mode));
         for (auto &i: data)
             i = rand();
         return move(data);
@@ -36,14 +43,18 @@ int main(int argc, char** argv) {
 
     for (int i = 0; i < iter_count; ++i) {
         cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto before_generator = footprint_now();
         auto data = vector_generator(size_max);
+        auto before_run = footprint_now();
         for (int size = step; size <= size_max; size += step) {
             cout << "\tsize " << size << "/" << size_max << endl;
             for (int threads = 1; threads <= threads_max; ++threads) {
                 cout << "\t\tthreads " << threads << "/" << threads_max << endl;
-                times[threads-1][size/step-1] += run(data, threads, size);
+                times[threads-1][size/step-1] += store.add("run", size, threads, run(data, threads, size));
             }
         }
+        print_footprint("generator", before_generator, before_run);
+        print_footprint("run", before_run, footprint_now());
     }
 
     cout << endl;
@@ -55,5 +66,6 @@ int main(int argc, char** argv) {
         }
         cout << endl;
     }
+    cout << "results " << store.save() << endl;
     return 0;
 }
\ No newline at end of file
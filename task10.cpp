@@ -3,6 +3,7 @@
 #include <omp.h>
 #include <iomanip>
 #include <algorithm>
+#include "results_store.h"
 
 using namespace std;
 
@@ -53,6 +54,7 @@ double run_B(const vector<vector<int>> &data, int threads, int size) {
 
 int main() {
     int threads_max = omp_get_max_threads();
+    results_store store("task10");
     vector times_A(threads_max, 0.);
     vector times_B(threads_max, 0.);
     int iter_count = 10;
@@ -72,8 +74,8 @@ int main() {
         auto data = matrix_generator(size);
         for (int threads = 1; threads <= threads_max; ++threads) {
             cout << "\t\tthreads " << threads << "/" << threads_max << endl;
-            times_A[threads-1] += run_A(data, threads, size);
-            times_B[threads-1] += run_B(data, threads, size);
+            times_A[threads-1] += store.add("A", size, threads, run_A(data, threads, size));
+            times_B[threads-1] += store.add("B", size, threads, run_B(data, threads, size));
         }
     }
 
@@ -92,6 +94,7 @@ int main() {
     }
     cout << endl;
 
+    cout << "results " << store.save() << endl;
     return 0;
 }
 
@@ -3,6 +3,8 @@
 #include <omp.h>
 #include <iomanip>
 #include <algorithm>
+#include "results_store.h"
+#include "autotune.h"
 
 using namespace std;
 
@@ -70,8 +72,23 @@ double run_runtime(const vector<int> &data, int threads, int size) {
     return omp_get_wtime() - time;
 }
 
+double run_tuned(const vector<int> &data, const tune_config &config, int size) {
+    double time = omp_get_wtime();
+
+    parallel_for_tuned(config, size, [&data](int i) {
+        for (int j = 0; j < data[i]; j++) {
+            vector t(100,0);
+            for (auto &i : t)
+                i = rand();
+        }
+    });
+
+    return omp_get_wtime() - time;
+}
+
 int main() {
     int threads_max = omp_get_max_threads();
+    results_store store("task11");
     vector times_static(threads_max, 0.);
     vector times_dynamic(threads_max, 0.);
     vector times_guided(threads_max, 0.);
@@ -88,15 +105,22 @@ int main() {
         return data;
     };
 
+    auto config = autotune("task11", size_max, [&](const tune_config &c) {
+        return run_tuned(triang_generator(size_max), c, size_max);
+    });
+    cout << "tuned " << to_string(config) << endl;
+    double time_tuned = 0;
+
     for (int i = 0; i < iter_count; ++i) {
         cout << "iter " << i +1 << "/" << iter_count << endl;
         auto triang = triang_generator(size_max);
+        time_tuned += store.add("tuned", size_max, config.threads, run_tuned(triang, config, size_max));
         for (int threads = 1; threads <= threads_max; ++threads) {
             cout << "\t\tthreads " << threads << "/" << threads_max << endl;
-            times_dynamic[threads-1] += run_dynamic(triang, threads, size_max);
-            times_static[threads-1] += run_static(triang, threads, size_max);
-            times_guided[threads-1] += run_guided(triang, threads, size_max);
-            times_runtime[threads-1] += run_runtime(triang, threads, size_max);
+            times_dynamic[threads-1] += store.add("dynamic", size_max, threads, run_dynamic(triang, threads, size_max));
+            times_static[threads-1] += store.add("static", size_max, threads, run_static(triang, threads, size_max));
+            times_guided[threads-1] += store.add("guided", size_max, threads, run_guided(triang, threads, size_max));
+            times_runtime[threads-1] += store.add("runtime", size_max, threads, run_runtime(triang, threads, size_max));
         }
     }
 
@@ -115,6 +139,8 @@ int main() {
     print(times_dynamic, "dynamic");
     print(times_guided,"guided");
     print(times_runtime, "runtime");
+    cout << "tuned (" << to_string(config) << ")" << endl << time_tuned / iter_count << endl;
+    cout << "results " << store.save() << endl;
     return 0;
 }
 
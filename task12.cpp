@@ -0,0 +1,311 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <array>
+#include <cstdint>
+#include <omp.h>
+#include "results_store.h"
+
+using namespace std;
+
+const int top_k = 100;
+const double percentile = 0.5;
+const int bins_count = 256;
+
+// Maps [0, RAND_MAX] onto [0, bins_count) without a division,
+// so the loop computing bin indices vectorizes.
+inline int bin_of(int x) {
+    return (int) (((uint64_t) x * bins_count) >> 31);
+}
+
+// results of the last kernel call, stored after its timer has stopped
+struct kernel_result {
+    vector<int> top;
+    int nth = 0;
+    vector<long long> bins;
+};
+
+kernel_result last;
+
+// serial results for the first size elements of data, scratch is overwritten
+kernel_result reference(const vector<int> &data, vector<int> &scratch, int size) {
+    kernel_result res;
+    res.top.resize(min(top_k, size));
+    partial_sort_copy(data.begin(), data.begin() + size, res.top.begin(), res.top.end(), greater<>());
+
+    int k = (int) (percentile * (size - 1));
+    copy(data.begin(), data.begin() + size, scratch.begin());
+    nth_element(scratch.begin(), scratch.begin() + k, scratch.begin() + size);
+    res.nth = scratch[k];
+
+    res.bins.assign(bins_count, 0);
+    for (int i = 0; i < size; ++i)
+        ++res.bins[bin_of(data[i])];
+    return res;
+}
+
+bool matches(const string &name, const kernel_result &expected) {
+    if (name == "top_k")
+        return last.top == expected.top;
+    if (name == "nth_element")
+        return last.nth == expected.nth;
+    return last.bins == expected.bins;
+}
+
+double run_top_k(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    double time = omp_get_wtime();
+    omp_set_num_threads(threads);
+    vector<vector<int>> heaps(threads);
+
+#pragma omp parallel default(shared)
+    {
+        // min-heap holding the k largest elements seen by this thread
+        vector<int> heap;
+        heap.reserve(top_k);
+#pragma omp for schedule(static)
+        for (int i = 0; i < size; ++i) {
+            if (heap.size() < top_k) {
+                heap.push_back(data[i]);
+                push_heap(heap.begin(), heap.end(), greater<>());
+            } else if (data[i] > heap.front()) {
+                pop_heap(heap.begin(), heap.end(), greater<>());
+                heap.back() = data[i];
+                push_heap(heap.begin(), heap.end(), greater<>());
+            }
+        }
+        heaps[omp_get_thread_num()] = move(heap);
+    }
+
+    vector<int> top;
+    for (const auto &heap : heaps)
+        top.insert(top.end(), heap.begin(), heap.end());
+    int k = min<int>(top_k, top.size());
+    partial_sort(top.begin(), top.begin() + k, top.end(), greater<>());
+    top.resize(k);
+
+    double elapsed = omp_get_wtime() - time;
+    last.top = move(top);
+    return elapsed;
+}
+
+double run_nth_element(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    double time = omp_get_wtime();
+    omp_set_num_threads(threads);
+
+#pragma omp parallel for default(shared) schedule(static)
+    for (int i = 0; i < size; ++i)
+        work[i] = data[i];
+
+    // src may point into the middle of its buffer, dst always starts one
+    int *src = work.data();
+    int *src_buf = work.data();
+    int *dst = tmp.data();
+    int n = size;
+    int k = (int) (percentile * (size - 1));
+    int result = 0;
+    bool found = false;
+
+    // per-thread {less, greater} counts, padded to separate cache lines;
+    // the team may be smaller than requested (OMP_THREAD_LIMIT, OMP_DYNAMIC)
+    vector<array<int, 16>> counts(threads);
+    int team = threads;
+
+    while (!found && n > (1 << 16)) {
+        int a = src[0], b = src[n / 2], c = src[n - 1];
+        int pivot = max(min(a, b), min(max(a, b), c));
+
+#pragma omp parallel default(shared) num_threads(threads)
+        {
+            int t = omp_get_thread_num();
+            int team_size = omp_get_num_threads();
+            if (t == 0)
+                team = team_size;
+            int from = (int) ((long long) n * t / team_size);
+            int to = (int) ((long long) n * (t + 1) / team_size);
+            int less = 0, greater = 0;
+            for (int i = from; i < to; ++i) {
+                less += src[i] < pivot;
+                greater += src[i] > pivot;
+            }
+            counts[t][0] = less;
+            counts[t][1] = greater;
+#pragma omp barrier
+            int less_total = 0, less_off = 0, greater_off = 0;
+            for (int j = 0; j < team_size; ++j) {
+                less_total += counts[j][0];
+                if (j < t) {
+                    less_off += counts[j][0];
+                    greater_off += counts[j][1];
+                }
+            }
+            // less go to the front of dst, greater right after them
+            greater_off += less_total;
+            for (int i = from; i < to; ++i) {
+                if (src[i] < pivot)
+                    dst[less_off++] = src[i];
+                else if (src[i] > pivot)
+                    dst[greater_off++] = src[i];
+            }
+        }
+
+        int less = 0, greater = 0;
+        for (int j = 0; j < team; ++j) {
+            less += counts[j][0];
+            greater += counts[j][1];
+        }
+        int equal = n - less - greater;
+
+        if (k < less + equal && k >= less) {
+            result = pivot;
+            found = true;
+        } else {
+            if (k < less) {
+                n = less;
+                src = dst;
+            } else {
+                k -= less + equal;
+                n = greater;
+                src = dst + less;
+            }
+            swap(src_buf, dst);
+        }
+    }
+
+    if (!found) {
+        nth_element(src, src + k, src + n);
+        result = src[k];
+    }
+
+    double elapsed = omp_get_wtime() - time;
+    last.nth = result;
+    return elapsed;
+}
+
+double run_histogram_atomic(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    double time = omp_get_wtime();
+    omp_set_num_threads(threads);
+    vector<long long> bins(bins_count, 0);
+
+#pragma omp parallel for default(shared)
+    for (int i = 0; i < size; ++i)
+#pragma omp atomic
+        ++bins[bin_of(data[i])];
+
+    double elapsed = omp_get_wtime() - time;
+    last.bins = move(bins);
+    return elapsed;
+}
+
+double run_histogram_private(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    double time = omp_get_wtime();
+    omp_set_num_threads(threads);
+    vector<long long> bins(bins_count, 0);
+    long long *b = bins.data();
+
+#pragma omp parallel for default(shared) reduction(+:b[:bins_count])
+    for (int i = 0; i < size; ++i)
+        ++b[bin_of(data[i])];
+
+    double elapsed = omp_get_wtime() - time;
+    last.bins = move(bins);
+    return elapsed;
+}
+
+double run_histogram_simd(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    double time = omp_get_wtime();
+    omp_set_num_threads(threads);
+    vector<long long> bins(bins_count, 0);
+    const int block = 1024;
+    const int copies = 4;
+
+#pragma omp parallel default(shared)
+    {
+        // several sub-histograms break the store-to-load chain on repeated bins
+        vector<int> local(copies * bins_count, 0);
+        int idx[block];
+#pragma omp for schedule(static)
+        for (int from = 0; from < size; from += block) {
+            int len = min(block, size - from);
+            const int *p = data.data() + from;
+#pragma omp simd
+            for (int i = 0; i < len; ++i)
+                idx[i] = bin_of(p[i]) + (i % copies) * bins_count;
+            for (int i = 0; i < len; ++i)
+                ++local[idx[i]];
+        }
+        for (int j = 0; j < bins_count; ++j) {
+            long long sum = 0;
+            for (int c = 0; c < copies; ++c)
+                sum += local[c * bins_count + j];
+#pragma omp atomic
+            bins[j] += sum;
+        }
+    }
+
+    double elapsed = omp_get_wtime() - time;
+    last.bins = move(bins);
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    int threads_max = omp_get_max_threads();
+    results_store store("task12");
+    map<string, function<double(const vector<int> &, vector<int> &, vector<int> &, int, int)>> funcs{
+            {"top_k",             run_top_k},
+            {"nth_element",       run_nth_element},
+            {"histogram_atomic",  run_histogram_atomic},
+            {"histogram_private", run_histogram_private},
+            {"histogram_simd",    run_histogram_simd}
+    };
+    map<string, vector<vector<double>>> times;
+    for (auto &[name, func] : funcs)
+        times[name] = vector(threads_max, vector(100, 0.));
+
+    auto vector_generator = [](int size) {
+        vector data(size, 0);
+        for (auto &i: data)
+            i = rand();
+        return move(data);
+    };
+
+    int iter_count = 10;
+    int size_max = 100'000'000;
+    int step = 1'000'000;
+
+    for (int i = 0; i < iter_count; ++i) {
+        cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto data = vector_generator(size_max);
+        // scratch space of nth_element, allocated outside the timed kernels
+        vector<int> work(size_max), tmp(size_max);
+        for (int size = step; size <= size_max; size += step) {
+            cout << "\tsize " << size << "/" << size_max << endl;
+            auto expected = reference(data, tmp, size);
+            for (int threads = 1; threads <= threads_max; ++threads) {
+                cout << "\t\tthreads " << threads << "/" << threads_max << endl;
+                for (auto &[name, func] : funcs) {
+                    times[name][threads-1][size/step-1] += store.add(name, size, threads, func(data, work, tmp, threads, size));
+                    if (!matches(name, expected))
+                        cout << "\t\t" << name << " result is wrong" << endl;
+                }
+            }
+        }
+    }
+
+    cout << endl;
+    std::cout << std::fixed;
+    std::cout << std::setprecision(6);
+    for (const auto& [name, matrix] : times) {
+        cout << name << endl;
+        for (const auto& thread : matrix) {
+            for (const auto time : thread) {
+                cout << time / iter_count << " ";
+            }
+            cout << endl;
+        }
+    }
+    cout << "results " << store.save() << endl;
+    return 0;
+}
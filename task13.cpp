@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+#include "parallel_backend.h"
+#include "results_store.h"
+
+using namespace std;
+
+// omp_get_wtime is not available when the backend is not OpenMP
+double wtime() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// average cost of one empty fork/join
+double run_fork_join(parallel_backend &backend, int threads) {
+    int reps = 1000;
+    double time = wtime();
+    for (int r = 0; r < reps; ++r)
+        backend.parallel_for(threads, threads, schedule_kind::static_, 0, [](int, int, int) {});
+    return (wtime() - time) / reps;
+}
+
+double run_reduction(parallel_backend &backend, const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+    double time = wtime();
+    long long res = parallel_reduce(backend, size, threads, 0LL, [&](int begin, int end) {
+        long long sum = 0;
+        for (int i = begin; i < end; ++i)
+            sum += vec1[i] * vec2[i];
+        return sum;
+    }, plus<>());
+    return wtime() - time;
+}
+
+double run_minmax(parallel_backend &backend, const vector<vector<int>> &data, int threads, int size) {
+    double time = wtime();
+    int minmax = parallel_reduce(backend, size, threads, INT_MIN, [&](int begin, int end) {
+        int res = INT_MIN;
+        for (int i = begin; i < end; ++i)
+            res = max(res, *min_element(data[i].begin(), data[i].end()));
+        return res;
+    }, [](int a, int b) { return max(a, b); });
+    return wtime() - time;
+}
+
+// the task11 triangular workload, rand() replaced by a private generator
+// so that the libc lock does not dominate the comparison
+double run_schedule(parallel_backend &backend, const vector<int> &data, int threads, int size, schedule_kind s) {
+    double time = wtime();
+    backend.parallel_for(size, threads, s, 1, [&](int, int begin, int end) {
+        unsigned seed = begin;
+        for (int i = begin; i < end; ++i) {
+            for (int j = 0; j < data[i]; j++) {
+                vector t(100, 0);
+                for (auto &el : t)
+                    el = seed = seed * 1103515245 + 12345;
+            }
+        }
+    });
+    return wtime() - time;
+}
+
+int main(int argc, char **argv) {
+    int threads_max = thread::hardware_concurrency();
+    results_store store("task13");
+    // task13 [all|omp|pool|std]
+    auto backends = make_backends(argc > 1 ? argv[1] : "all", threads_max);
+
+    int iter_count = 10;
+    int size_max = 100'000'000;
+    int rows = 10'000;
+    int tasks_size = 10'000;
+
+    auto vector_generator = [](int size) {
+        vector data(size, 0);
+        for (auto &i: data)
+            i = rand() % 10'000;
+        return move(data);
+    };
+
+    auto matrix_generator = [](int size) {
+        vector data(size, vector(size, 0));
+        for (auto &row: data)
+            for (auto &i : row)
+                i = rand();
+        return move(data);
+    };
+
+    auto triang_generator = [](int size) {
+        vector data(size, 0);
+        for (int i = 0; i < size; ++i) {
+            data[i] = i/50 + rand()%10 + 1;
+        }
+        return data;
+    };
+
+    vector<string> kernels{"fork_join", "reduction", "minmax", "static", "dynamic"};
+    map<string, map<string, vector<double>>> times;
+    for (auto &backend : backends)
+        for (auto &kernel : kernels)
+            times[backend->name()][kernel] = vector(threads_max, 0.);
+
+    for (int i = 0; i < iter_count; ++i) {
+        cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto vec1 = vector_generator(size_max);
+        auto vec2 = vector_generator(size_max);
+        auto matrix = matrix_generator(rows);
+        auto triang = triang_generator(tasks_size);
+        for (auto &backend : backends) {
+            auto &t = times[backend->name()];
+            string name = backend->name() + "_";
+            cout << "\t" << backend->name() << endl;
+            for (int threads = 1; threads <= threads_max; ++threads) {
+                cout << "\t\tthreads " << threads << "/" << threads_max << endl;
+                t["fork_join"][threads-1] += store.add(name + "fork_join", 0, threads, run_fork_join(*backend, threads));
+                t["reduction"][threads-1] += store.add(name + "reduction", size_max, threads, run_reduction(*backend, vec1, vec2, threads, size_max));
+                t["minmax"][threads-1] += store.add(name + "minmax", rows, threads, run_minmax(*backend, matrix, threads, rows));
+                t["static"][threads-1] += store.add(name + "static", tasks_size, threads, run_schedule(*backend, triang, threads, tasks_size, schedule_kind::static_));
+                t["dynamic"][threads-1] += store.add(name + "dynamic", tasks_size, threads, run_schedule(*backend, triang, threads, tasks_size, schedule_kind::dynamic));
+            }
+        }
+    }
+
+    cout << endl;
+    std::cout << std::fixed;
+    std::cout << std::setprecision(6);
+    for (auto &[backend, kernel_times] : times) {
+        for (auto &kernel : kernels) {
+            cout << backend << " " << kernel << endl;
+            for (auto time : kernel_times[kernel])
+                cout << time / iter_count << " ";
+            cout << endl;
+        }
+    }
+    cout << "results " << store.save() << endl;
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <climits>
+#include <omp.h>
+#include "results_store.h"
+
+using namespace std;
+
+struct min_op {
+    template <typename T>
+    T operator()(T a, T b) const { return a < b ? a : b; }
+};
+
+struct max_op {
+    template <typename T>
+    T operator()(T a, T b) const { return a < b ? b : a; }
+};
+
+// Sequential scan of [in, in+n) starting from init. Returns the
+// aggregate op(init, in[0], ..., in[n-1]).
+template <typename In, typename T, typename Op>
+T scan_seq(const In *in, T *out, int n, T init, Op op, bool inclusive) {
+    T acc = init;
+    for (int i = 0; i < n; ++i) {
+        T next = op(acc, (T) in[i]);
+        out[i] = inclusive ? next : acc;
+        acc = next;
+    }
+    return acc;
+}
+
+// Inclusive scan in groups of `width` elements: log2(width) shift-and-combine
+// steps inside the group (the in-register part), then the carry of the
+// previous groups is folded in. Gives the same result for any associative op.
+template <int width = 8, typename In, typename T, typename Op>
+T scan_simd(const In *in, T *out, int n, T init, T identity, Op op) {
+    T carry = init;
+    int i = 0;
+    for (; i + width <= n; i += width) {
+        T v[width], shifted[width];
+#pragma omp simd
+        for (int j = 0; j < width; ++j)
+            v[j] = (T) in[i + j];
+        for (int k = 1; k < width; k *= 2) {
+#pragma omp simd
+            for (int j = 0; j < width; ++j)
+                shifted[j] = j >= k ? v[j - k] : identity;
+#pragma omp simd
+            for (int j = 0; j < width; ++j)
+                v[j] = op(shifted[j], v[j]);
+        }
+#pragma omp simd
+        for (int j = 0; j < width; ++j)
+            out[i + j] = op(carry, v[j]);
+        carry = out[i + width - 1];
+    }
+    return scan_seq(in + i, out + i, n - i, carry, op, true);
+}
+
+// Classic blocked scan: every thread reduces its block, the block
+// aggregates are scanned exclusively, then every thread scans its block
+// again starting from its prefix.
+template <typename In, typename T, typename Op>
+void scan_two_pass(const In *in, T *out, int n, int threads, T identity, Op op, bool inclusive, bool simd = false) {
+    vector<T> partials(threads + 1, identity);
+#pragma omp parallel num_threads(threads)
+    {
+        // the team may be smaller than requested (OMP_THREAD_LIMIT, OMP_DYNAMIC)
+        int t = omp_get_thread_num();
+        int team = omp_get_num_threads();
+        int from = (int) ((long long) n * t / team);
+        int to = (int) ((long long) n * (t + 1) / team);
+
+        T acc = identity;
+        for (int i = from; i < to; ++i)
+            acc = op(acc, (T) in[i]);
+        partials[t + 1] = acc;
+#pragma omp barrier
+#pragma omp single
+        for (int j = 1; j <= team; ++j)
+            partials[j] = op(partials[j - 1], partials[j]);
+
+        if (simd && inclusive)
+            scan_simd(in + from, out + from, to - from, partials[t], identity, op);
+        else
+            scan_seq(in + from, out + from, to - from, partials[t], op, inclusive);
+    }
+}
+
+// Single pass scan with decoupled look-back. Blocks are taken in order
+// from a ticket counter; a block publishes its aggregate as soon as it
+// is scanned locally, then walks back over its predecessors until it
+// meets one that already knows its inclusive prefix.
+template <typename In, typename T, typename Op>
+void scan_lookback(const In *in, T *out, int n, int threads, T identity, Op op, int block = 1 << 16) {
+    enum { flag_none, flag_aggregate, flag_prefix };
+    struct alignas(64) block_state {
+        atomic<int> flag{flag_none};
+        T aggregate;
+        T prefix;
+    };
+    int blocks = (n + block - 1) / block;
+    vector<block_state> state(blocks);
+    atomic<int> ticket{0};
+
+#pragma omp parallel num_threads(threads)
+    for (int b; (b = ticket.fetch_add(1, memory_order_relaxed)) < blocks;) {
+        int from = b * block;
+        int len = min(block, n - from);
+        T local = scan_seq(in + from, out + from, len, identity, op, true);
+
+        if (b == 0) {
+            state[b].prefix = local;
+            state[b].flag.store(flag_prefix, memory_order_release);
+            continue;
+        }
+        state[b].aggregate = local;
+        state[b].flag.store(flag_aggregate, memory_order_release);
+
+        T exclusive = identity;
+        for (int p = b - 1; p >= 0;) {
+            int flag = state[p].flag.load(memory_order_acquire);
+            if (flag == flag_none)
+                continue;
+            if (flag == flag_prefix) {
+                exclusive = op(state[p].prefix, exclusive);
+                break;
+            }
+            exclusive = op(state[p].aggregate, exclusive);
+            --p;
+        }
+        state[b].prefix = op(exclusive, local);
+        state[b].flag.store(flag_prefix, memory_order_release);
+
+        for (int i = from; i < from + len; ++i)
+            out[i] = op(exclusive, out[i]);
+    }
+}
+
+// Stream compaction: keeps the elements matching pred, in order.
+// Per-thread counts are scanned to get every thread's output offset.
+template <typename T, typename Pred>
+int compact(const T *in, T *out, int n, int threads, Pred pred) {
+    vector<int> offsets(threads + 1, 0);
+    int team = threads;
+#pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num();
+        int team_size = omp_get_num_threads();
+        if (t == 0)
+            team = team_size;
+        int from = (int) ((long long) n * t / team_size);
+        int to = (int) ((long long) n * (t + 1) / team_size);
+
+        int count = 0;
+        for (int i = from; i < to; ++i)
+            count += pred(in[i]);
+        offsets[t + 1] = count;
+#pragma omp barrier
+#pragma omp single
+        for (int j = 1; j <= team_size; ++j)
+            offsets[j] += offsets[j - 1];
+
+        int pos = offsets[t];
+        for (int i = from; i < to; ++i)
+            if (pred(in[i]))
+                out[pos++] = in[i];
+    }
+    return offsets[team];
+}
+
+double run_inclusive_sum(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    double time = omp_get_wtime();
+    scan_two_pass(data.data(), out.data(), size, threads, 0LL, plus<>(), true);
+    return omp_get_wtime() - time;
+}
+
+double run_exclusive_sum(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    double time = omp_get_wtime();
+    scan_two_pass(data.data(), out.data(), size, threads, 0LL, plus<>(), false);
+    return omp_get_wtime() - time;
+}
+
+double run_simd_sum(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    double time = omp_get_wtime();
+    scan_two_pass(data.data(), out.data(), size, threads, 0LL, plus<>(), true, true);
+    return omp_get_wtime() - time;
+}
+
+double run_lookback_sum(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    double time = omp_get_wtime();
+    scan_lookback(data.data(), out.data(), size, threads, 0LL, plus<>());
+    return omp_get_wtime() - time;
+}
+
+double run_running_min(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    double time = omp_get_wtime();
+    scan_two_pass(data.data(), out.data(), size, threads, (long long) INT_MAX, min_op(), true);
+    return omp_get_wtime() - time;
+}
+
+double run_running_max(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    double time = omp_get_wtime();
+    scan_two_pass(data.data(), out.data(), size, threads, (long long) INT_MIN, max_op(), true);
+    return omp_get_wtime() - time;
+}
+
+double run_compact(const vector<int> &data, vector<long long> &out, vector<int> &kept_out, int threads, int size) {
+    auto pred = [](int x) { return x < RAND_MAX / 2; };
+    double time = omp_get_wtime();
+    int kept = compact(data.data(), kept_out.data(), size, threads, pred);
+    double elapsed = omp_get_wtime() - time;
+
+    if (kept != count_if(data.begin(), data.begin() + size, pred))
+        cout << "\t\tcompact kept a wrong number of elements" << endl;
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    int threads_max = omp_get_max_threads();
+    results_store store("task14");
+    map<string, function<double(const vector<int> &, vector<long long> &, vector<int> &, int, int)>> funcs{
+            {"inclusive_sum", run_inclusive_sum},
+            {"exclusive_sum", run_exclusive_sum},
+            {"simd_sum",      run_simd_sum},
+            {"lookback_sum",  run_lookback_sum},
+            {"running_min",   run_running_min},
+            {"running_max",   run_running_max},
+            {"compact",       run_compact}
+    };
+    map<string, vector<vector<double>>> times;
+    for (auto &[name, func] : funcs)
+        times[name] = vector(threads_max, vector(100, 0.));
+
+    auto vector_generator = [](int size) {
+        vector data(size, 0);
+        for (auto &i: data)
+            i = rand();
+        return move(data);
+    };
+
+    int iter_count = 10;
+    int size_max = 100'000'000;
+    int step = 1'000'000;
+
+    for (int i = 0; i < iter_count; ++i) {
+        cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto data = vector_generator(size_max);
+        vector<long long> out(size_max);
+        vector<int> kept_out(size_max);
+        for (int size = step; size <= size_max; size += step) {
+            cout << "\tsize " << size << "/" << size_max << endl;
+            for (int threads = 1; threads <= threads_max; ++threads) {
+                cout << "\t\tthreads " << threads << "/" << threads_max << endl;
+                for (auto &[name, func] : funcs)
+                    times[name][threads-1][size/step-1] += store.add(name, size, threads, func(data, out, kept_out, threads, size));
+            }
+        }
+    }
+
+    cout << endl;
+    std::cout << std::fixed;
+    std::cout << std::setprecision(6);
+    for (const auto& [name, matrix] : times) {
+        cout << name << endl;
+        for (const auto& thread : matrix) {
+            for (const auto time : thread) {
+                cout << time / iter_count << " ";
+            }
+            cout << endl;
+        }
+    }
+    cout << "results " << store.save() << endl;
+    return 0;
+}
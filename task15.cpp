@@ -0,0 +1,212 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <omp.h>
+#include "results_store.h"
+
+#if __has_include(<execution>)
+#include <execution>
+#define HAVE_STD_PAR
+#if __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#define HAVE_TBB_CONTROL
+#endif
+#endif
+
+using namespace std;
+
+const int sort_cutoff = 1 << 14;
+const int merge_cutoff = 1 << 15;
+
+// Merges [a, a+na) and [b, b+nb) into out. Large merges are split at the
+// middle of the longer run, the matching split point of the other one is
+// found by binary search and the two halves are merged as separate tasks.
+void parallel_merge(const int *a, int na, const int *b, int nb, int *out) {
+    if (na + nb <= merge_cutoff) {
+        merge(a, a + na, b, b + nb, out);
+        return;
+    }
+    if (na < nb) {
+        swap(a, b);
+        swap(na, nb);
+    }
+    int ma = na / 2;
+    int mb = lower_bound(b, b + nb, a[ma]) - b;
+#pragma omp task default(shared)
+    parallel_merge(a, ma, b, mb, out);
+    parallel_merge(a + ma, na - ma, b + mb, nb - mb, out + ma + mb);
+#pragma omp taskwait
+}
+
+// Sorts data[0, n) using tmp as scratch; the result ends up in tmp when
+// to_tmp is set and in data otherwise. The halves are sorted into the
+// buffer the merge reads from, so the buffers swap roles on every level
+// and nothing is copied back after a merge.
+void merge_sort(int *data, int *tmp, int n, bool to_tmp) {
+    if (n <= sort_cutoff) {
+        sort(data, data + n);
+        if (to_tmp)
+            copy(data, data + n, tmp);
+        return;
+    }
+    int m = n / 2;
+#pragma omp task default(shared)
+    merge_sort(data, tmp, m, !to_tmp);
+    merge_sort(data + m, tmp + m, n - m, !to_tmp);
+#pragma omp taskwait
+    if (to_tmp)
+        parallel_merge(data, m, data + m, n - m, tmp);
+    else
+        parallel_merge(tmp, m, tmp + m, n - m, data);
+}
+
+double run_merge_sort(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    copy(data.begin(), data.begin() + size, work.begin());
+    double time = omp_get_wtime();
+#pragma omp parallel num_threads(threads)
+#pragma omp single
+    merge_sort(work.data(), tmp.data(), size, false);
+    return omp_get_wtime() - time;
+}
+
+// LSD radix sort on 8-bit digits of non-negative ints. Every pass counts
+// digits per thread, turns the counts into per-(digit, thread) offsets
+// and scatters through small per-thread buffers, so threads write whole
+// cache lines instead of interleaving single stores into shared lines.
+double run_radix_sort(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    copy(data.begin(), data.begin() + size, work.begin());
+    double time = omp_get_wtime();
+
+    const int radix = 256;
+    const int line = 16;
+    vector<array<int, radix>> counts(threads);
+    int *src = work.data();
+    int *dst = tmp.data();
+
+    for (int shift = 0; shift < 32; shift += 8) {
+#pragma omp parallel num_threads(threads)
+        {
+            // the team may be smaller than requested (OMP_THREAD_LIMIT, OMP_DYNAMIC)
+            int t = omp_get_thread_num();
+            int team = omp_get_num_threads();
+            int from = (int) ((long long) size * t / team);
+            int to = (int) ((long long) size * (t + 1) / team);
+
+            auto &count = counts[t];
+            count.fill(0);
+            for (int i = from; i < to; ++i)
+                ++count[(src[i] >> shift) & (radix - 1)];
+#pragma omp barrier
+#pragma omp single
+            {
+                int offset = 0;
+                for (int d = 0; d < radix; ++d)
+                    for (int j = 0; j < team; ++j) {
+                        int c = counts[j][d];
+                        counts[j][d] = offset;
+                        offset += c;
+                    }
+            }
+
+            vector<int> buffer(radix * line);
+            array<int, radix> filled{};
+            for (int i = from; i < to; ++i) {
+                int d = (src[i] >> shift) & (radix - 1);
+                buffer[d * line + filled[d]++] = src[i];
+                if (filled[d] == line) {
+                    copy(&buffer[d * line], &buffer[d * line] + line, dst + count[d]);
+                    count[d] += line;
+                    filled[d] = 0;
+                }
+            }
+            for (int d = 0; d < radix; ++d)
+                copy(&buffer[d * line], &buffer[d * line] + filled[d], dst + count[d]);
+        }
+        swap(src, dst);
+    }
+
+    // four passes leave the result back in work
+    return omp_get_wtime() - time;
+}
+
+double run_std_sort(const vector<int> &data, vector<int> &work, vector<int> &tmp, int threads, int size) {
+    copy(data.begin(), data.begin() + size, work.begin());
+    double time = omp_get_wtime();
+#ifdef HAVE_STD_PAR
+#ifdef HAVE_TBB_CONTROL
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+#endif
+    sort(execution::par, work.begin(), work.begin() + size);
+#else
+    sort(work.begin(), work.begin() + size);
+#endif
+    return omp_get_wtime() - time;
+}
+
+int main(int argc, char** argv) {
+    int threads_max = omp_get_max_threads();
+    results_store store("task15");
+    map<string, function<double(const vector<int> &, vector<int> &, vector<int> &, int, int)>> funcs{
+            {"merge_sort", run_merge_sort},
+            {"radix_sort", run_radix_sort},
+            {"std_sort",   run_std_sort}
+    };
+    map<string, vector<vector<double>>> times;
+    for (auto &[name, func] : funcs)
+        times[name] = vector(threads_max, vector(10, 0.));
+
+    auto vector_generator = [](int size) {
+        vector data(size, 0);
+        for (auto &i: data)
+            i = rand();
+        return move(data);
+    };
+
+    int iter_count = 10;
+    int size_max = 100'000'000;
+    int step = 10'000'000;
+
+    for (int i = 0; i < iter_count; ++i) {
+        cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto data = vector_generator(size_max);
+        vector<int> work(size_max), tmp(size_max);
+        for (int size = step; size <= size_max; size += step) {
+            cout << "\tsize " << size << "/" << size_max << endl;
+            for (int threads = 1; threads <= threads_max; ++threads) {
+                cout << "\t\tthreads " << threads << "/" << threads_max << endl;
+                for (auto &[name, func] : funcs) {
+                    times[name][threads-1][size/step-1] += store.add(name, size, threads, func(data, work, tmp, threads, size));
+                    if (!is_sorted(work.begin(), work.begin() + size))
+                        cout << "\t\t" << name << " result is not sorted" << endl;
+                }
+            }
+        }
+    }
+
+    cout << endl;
+    std::cout << std::fixed;
+    std::cout << std::setprecision(6);
+    for (const auto& [name, matrix] : times) {
+        cout << name << endl;
+        for (const auto& thread : matrix) {
+            for (const auto time : thread) {
+                cout << time / iter_count << " ";
+            }
+            cout << endl;
+        }
+        // millions of elements sorted per second
+        cout << name << " Melem/s" << endl;
+        for (const auto& thread : matrix) {
+            for (int j = 0; j < thread.size(); ++j) {
+                cout << (double) step * (j + 1) * iter_count / thread[j] / 1e6 << " ";
+            }
+            cout << endl;
+        }
+    }
+    cout << "results " << store.save() << endl;
+    return 0;
+}
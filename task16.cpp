@@ -0,0 +1,273 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <mpi.h>
+#include <omp.h>
+#include "results_store.h"
+
+using namespace std;
+
+// time spent computing and waiting for communication on this rank
+struct breakdown {
+    double total = 0;
+    double compute = 0;
+    double comm = 0;
+
+    breakdown &operator+=(const breakdown &other) {
+        total += other.total;
+        compute += other.compute;
+        comm += other.comm;
+        return *this;
+    }
+};
+
+long long local_dot(const int *vec1, const int *vec2, int size) {
+    long long res = 0;
+#pragma omp parallel for default(shared) reduction(+:res)
+    for (int i = 0; i < size; ++i)
+        res += vec1[i] * vec2[i];
+    return res;
+}
+
+// every rank owns one contiguous block of both vectors
+breakdown run_dot(const vector<int> &vec1, const vector<int> &vec2) {
+    breakdown res;
+    double time = MPI_Wtime();
+    long long local = local_dot(vec1.data(), vec2.data(), vec1.size());
+    res.compute = MPI_Wtime() - time;
+
+    long long global = 0;
+    double comm = MPI_Wtime();
+    MPI_Allreduce(&local, &global, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    res.comm = MPI_Wtime() - comm;
+    res.total = MPI_Wtime() - time;
+    return res;
+}
+
+// the local block is reduced in chunks, the allreduce of one chunk is in
+// flight while the next one is computed
+breakdown run_dot_overlap(const vector<int> &vec1, const vector<int> &vec2, int chunks = 8) {
+    breakdown res;
+    double time = MPI_Wtime();
+    int size = vec1.size();
+    vector<long long> local(chunks), global(chunks);
+    vector<MPI_Request> requests(chunks);
+
+    for (int c = 0; c < chunks; ++c) {
+        int from = (int) ((long long) size * c / chunks);
+        int to = (int) ((long long) size * (c + 1) / chunks);
+        double compute = MPI_Wtime();
+        local[c] = local_dot(vec1.data() + from, vec2.data() + from, to - from);
+        res.compute += MPI_Wtime() - compute;
+
+        double comm = MPI_Wtime();
+        MPI_Iallreduce(&local[c], &global[c], 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD, &requests[c]);
+        res.comm += MPI_Wtime() - comm;
+    }
+    double comm = MPI_Wtime();
+    MPI_Waitall(chunks, requests.data(), MPI_STATUSES_IGNORE);
+    res.comm += MPI_Wtime() - comm;
+    long long dot = accumulate(global.begin(), global.end(), 0LL);
+
+    res.total = MPI_Wtime() - time;
+    return res;
+}
+
+// pr x pc process grid, every rank owns an (n/pr) x (n/pc) block of A, B and C
+struct grid {
+    int pr, pc, row, col;
+    MPI_Comm row_comm, col_comm;    // ranks of the same grid row / column
+    int n, rows, cols, panel;
+
+    grid(int ranks, int rank, int n_req) {
+        int dims[2] = {0, 0};
+        MPI_Dims_create(ranks, 2, dims);
+        pr = dims[0];
+        pc = dims[1];
+        row = rank / pc;
+        col = rank % pc;
+        MPI_Comm_split(MPI_COMM_WORLD, row, col, &row_comm);
+        MPI_Comm_split(MPI_COMM_WORLD, col, row, &col_comm);
+
+        // round n up so that the blocks divide it evenly
+        int l = lcm(pr, pc);
+        n = (n_req + l - 1) / l * l;
+        rows = n / pr;
+        cols = n / pc;
+        // a panel never crosses a block boundary in either direction
+        panel = gcd(rows, cols);
+    }
+
+    void free() {
+        MPI_Comm_free(&row_comm);
+        MPI_Comm_free(&col_comm);
+    }
+};
+
+// SUMMA: for every panel of width b the owners broadcast their slice of A
+// along the grid row and of B along the grid column, then every rank adds
+// the panel product to its block of C. With overlap the broadcasts of the
+// next panel are posted before the current panel is multiplied.
+breakdown run_summa(const grid &g, const vector<int> &a, const vector<int> &b, vector<int> &c, bool overlap) {
+    breakdown res;
+    double time = MPI_Wtime();
+    int rows = g.rows, cols = g.cols, bw = g.panel;
+    fill(c.begin(), c.end(), 0);
+
+    vector<int> a_panel[2], b_panel[2];
+    for (int i = 0; i < 2; ++i) {
+        a_panel[i].resize(rows * bw);
+        b_panel[i].resize(bw * cols);
+    }
+    MPI_Request requests[2][2];
+
+    auto post = [&](int k, int buf) {
+        int owner_col = k / cols, owner_row = k / rows;
+        if (g.col == owner_col)
+            for (int i = 0; i < rows; ++i)
+                copy_n(&a[i * cols + k % cols], bw, &a_panel[buf][i * bw]);
+        if (g.row == owner_row)
+            copy_n(&b[(k % rows) * cols], bw * cols, b_panel[buf].data());
+        MPI_Ibcast(a_panel[buf].data(), rows * bw, MPI_INT, owner_col, g.row_comm, &requests[buf][0]);
+        MPI_Ibcast(b_panel[buf].data(), bw * cols, MPI_INT, owner_row, g.col_comm, &requests[buf][1]);
+    };
+
+    for (int k = 0, buf = 0; k < g.n; k += bw, buf ^= 1) {
+        double comm = MPI_Wtime();
+        if (!overlap || k == 0)
+            post(k, buf);
+        MPI_Waitall(2, requests[buf], MPI_STATUSES_IGNORE);
+        if (overlap && k + bw < g.n)
+            post(k + bw, buf ^ 1);
+        res.comm += MPI_Wtime() - comm;
+
+        double compute = MPI_Wtime();
+        const int *ap = a_panel[buf].data();
+        const int *bp = b_panel[buf].data();
+#pragma omp parallel for default(shared)
+        for (int i = 0; i < rows; ++i)
+            for (int kk = 0; kk < bw; ++kk) {
+                int aik = ap[i * bw + kk];
+                for (int j = 0; j < cols; ++j)
+                    c[i * cols + j] += aik * bp[kk * cols + j];
+            }
+        res.compute += MPI_Wtime() - compute;
+    }
+
+    res.total = MPI_Wtime() - time;
+    return res;
+}
+
+// sum of all elements of C equals sum_k (sum_i A[i][k]) (sum_j B[k][j])
+bool check_summa(const grid &g, const vector<int> &a, const vector<int> &b, const vector<int> &c) {
+    vector<long long> col_a(g.n, 0), row_b(g.n, 0), col_sum(g.n), row_sum(g.n);
+    for (int i = 0; i < g.rows; ++i)
+        for (int j = 0; j < g.cols; ++j) {
+            col_a[g.col * g.cols + j] += a[i * g.cols + j];
+            row_b[g.row * g.rows + i] += b[i * g.cols + j];
+        }
+    MPI_Allreduce(col_a.data(), col_sum.data(), g.n, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(row_b.data(), row_sum.data(), g.n, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    long long expected = inner_product(col_sum.begin(), col_sum.end(), row_sum.begin(), 0LL);
+
+    long long local = accumulate(c.begin(), c.end(), 0LL), actual = 0;
+    MPI_Allreduce(&local, &actual, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    return expected == actual;
+}
+
+int main(int argc, char **argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int ranks, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int threads = omp_get_max_threads();
+    srand(rank + 1);
+
+    int iter_count = 10;
+    int size_max = 100'000'000;
+    int n_max = 1'000;
+
+    auto vector_generator = [](int size) {
+        vector data(size, 0);
+        for (auto &i: data)
+            i = rand() % 10'000;
+        return move(data);
+    };
+
+    grid g(ranks, rank, n_max);
+    auto block_generator = [&g]() {
+        vector data(g.rows * g.cols, 0);
+        for (auto &i: data)
+            i = rand() % 1000;
+        return move(data);
+    };
+
+    results_store store("task16");
+    string config = "_" + to_string(ranks) + "x" + to_string(threads);
+    int local_size = (int) ((long long) size_max * (rank + 1) / ranks - (long long) size_max * rank / ranks);
+    vector<string> kernels{"dot", "dot_overlap", "summa", "summa_overlap"};
+    vector<breakdown> times(kernels.size());
+
+    for (int i = 0; i < iter_count; ++i) {
+        if (rank == 0)
+            cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto vec1 = vector_generator(local_size);
+        auto vec2 = vector_generator(local_size);
+        auto a = block_generator();
+        auto b = block_generator();
+        vector<int> c(a.size());
+
+        // a kernel takes as long as its slowest rank
+        auto record = [&](int k, const breakdown &t) {
+            times[k] += t;
+            double slowest = 0;
+            MPI_Reduce(&t.total, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+            long size = kernels[k].rfind("dot", 0) == 0 ? size_max : g.n;
+            if (rank == 0)
+                store.add(kernels[k] + config, size, ranks * threads, slowest);
+        };
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        record(0, run_dot(vec1, vec2));
+        MPI_Barrier(MPI_COMM_WORLD);
+        record(1, run_dot_overlap(vec1, vec2));
+        MPI_Barrier(MPI_COMM_WORLD);
+        record(2, run_summa(g, a, b, c, false));
+        MPI_Barrier(MPI_COMM_WORLD);
+        record(3, run_summa(g, a, b, c, true));
+        if (!check_summa(g, a, b, c) && rank == 0)
+            cout << "\tsumma result is wrong" << endl;
+    }
+
+    // per-rank total / compute / comm, gathered on rank 0
+    vector<double> local_times, all_times(rank == 0 ? ranks * kernels.size() * 3 : 0);
+    for (auto &t : times) {
+        local_times.push_back(t.total / iter_count);
+        local_times.push_back(t.compute / iter_count);
+        local_times.push_back(t.comm / iter_count);
+    }
+    MPI_Gather(local_times.data(), local_times.size(), MPI_DOUBLE,
+               all_times.data(), local_times.size(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        cout << endl;
+        std::cout << std::fixed;
+        std::cout << std::setprecision(6);
+        cout << "ranks " << ranks << " threads " << threads << " grid " << g.pr << "x" << g.pc << " n " << g.n << endl;
+        for (int k = 0; k < kernels.size(); ++k) {
+            cout << kernels[k] << endl << "rank\ttotal\tcompute\tcomm" << endl;
+            for (int r = 0; r < ranks; ++r) {
+                const double *t = &all_times[(r * kernels.size() + k) * 3];
+                cout << r << "\t" << t[0] << "\t" << t[1] << "\t" << t[2] << endl;
+            }
+        }
+        cout << "results " << store.save() << endl;
+    }
+
+    g.free();
+    MPI_Finalize();
+    return 0;
+}
@@ -1,27 +1,106 @@
 #include <iomanip>
 #include <iostream>
 #include <vector>
+#include <cstdint>
+#include <numeric>
 #include <omp.h>
+#include "huge_pages.h"
+#include "results_store.h"
 
 using namespace std;
 
-double run(const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+using huge_vector = vector<int, huge_page_allocator<int>>;
+
+// Unsigned values of Bits bits packed back to back into 64-bit words.
+// A group of `group` values always ends on a word boundary, so a group
+// can be decoded with compile-time shifts and masks.
+template <int Bits>
+struct packed_vector {
+    static constexpr int lcm_bits = Bits * 64 / gcd(Bits, 64);
+    static constexpr int group = lcm_bits / Bits;
+    static constexpr int group_words = lcm_bits / 64;
+    static constexpr uint64_t mask = (uint64_t(1) << Bits) - 1;
+
+    vector<uint64_t> words;
+    int size = 0;
+
+    template <typename It>
+    packed_vector(It first, It last) : size(last - first) {
+        words.assign((size + group - 1) / group * group_words, 0);
+        for (int i = 0; first != last; ++first, ++i) {
+            uint64_t bit = (uint64_t) i * Bits;
+            uint64_t v = (uint64_t) *first & mask;
+            words[bit / 64] |= v << (bit % 64);
+            if (bit % 64 + Bits > 64)
+                words[bit / 64 + 1] |= v >> (64 - bit % 64);
+        }
+    }
+
+    // Unpacks values [g*group, (g+1)*group) into out
+    template <typename T>
+    void unpack(int g, T *out) const {
+        const uint64_t *w = words.data() + (size_t) g * group_words;
+        for (int j = 0; j < group; ++j) {
+            int bit = j * Bits;
+            uint64_t v = w[bit / 64] >> (bit % 64);
+            if (bit % 64 + Bits > 64)
+                v |= w[bit / 64 + 1] << (64 - bit % 64);
+            out[j] = (T) (v & mask);
+        }
+    }
+};
+
+// T is the storage type, Acc the type the products are widened to
+template <typename T, typename Acc = int64_t, typename Alloc = allocator<T>>
+double run(const vector<T, Alloc> &vec1, const vector<T, Alloc> &vec2, int threads, int size) {
     double time = omp_get_wtime();
-    int res = 0;
+    Acc res = 0;
     omp_set_num_threads(threads);
-#pragma omp parallel for default(shared) reduction(+:res)
+#pragma omp parallel for simd default(shared) reduction(+:res)
     for (int i = 0; i < size; ++i)
-        res += vec1[i]*vec2[i];
+        res += (Acc) vec1[i] * (Acc) vec2[i];
+
+    return omp_get_wtime() - time;
+}
+
+template <int Bits, typename Acc = int64_t>
+double run_packed(const packed_vector<Bits> &vec1, const packed_vector<Bits> &vec2, int threads, int size) {
+    using packed = packed_vector<Bits>;
+    double time = omp_get_wtime();
+    Acc res = 0;
+    omp_set_num_threads(threads);
+    int groups = size / packed::group;
+#pragma omp parallel for default(shared) reduction(+:res)
+    for (int g = 0; g < groups; ++g) {
+        Acc a[packed::group], b[packed::group];
+        vec1.unpack(g, a);
+        vec2.unpack(g, b);
+#pragma omp simd reduction(+:res)
+        for (int j = 0; j < packed::group; ++j)
+            res += a[j] * b[j];
+    }
+    if (groups * packed::group < size) {
+        Acc a[packed::group], b[packed::group];
+        vec1.unpack(groups, a);
+        vec2.unpack(groups, b);
+        for (int j = 0; j < size - groups * packed::group; ++j)
+            res += a[j] * b[j];
+    }
 
     return omp_get_wtime() - time;
 }
 
 int main(int argc, char **argv) {
     int threads_max = omp_get_max_threads();
+    results_store store("task2");
     vector times(threads_max, vector(100, 0.));
+    vector times16(threads_max, vector(100, 0.));
+    vector times_packed(threads_max, vector(100, 0.));
 
-    auto vector_generator = [](int size) {
-        vector data(1'000'000'000, 0);
+    // task2 [system|4k|thp|2m|1g] selects the page size backing the data
+    page_mode mode = parse_page_mode(argc > 1 ? argv[1] : "system");
+    auto vector_generator = [mode](int size) {
+        huge_vector data(1'000'000'000, 0, huge_page_allocator<int>(mode));
         for (auto &i: data)
             i = rand() % 10'000;
         return move(data);
@@ -33,26 +112,64 @@ int main(int argc, char **argv) {
 
     for (int i = 0; i < iter_count; ++i) {
         cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto before_generator = footprint_now();
         auto vec1 = vector_generator(size_max);
         auto vec2 = vector_generator(size_max);
+        // values are below 10'000, so 16 bits (or 14 packed bits) hold them
+        vector<int16_t, huge_page_allocator<int16_t>> vec1_16(vec1.begin(), vec1.begin() + size_max, huge_page_allocator<int16_t>(mode));
+        vector<int16_t, huge_page_allocator<int16_t>> vec2_16(vec2.begin(), vec2.begin() + size_max, huge_page_allocator<int16_t>(mode));
+        packed_vector<14> vec1_packed(vec1.begin(), vec1.begin() + size_max);
+        packed_vector<14> vec2_packed(vec2.begin(), vec2.begin() + size_max);
+        print_footprint("generator", before_generator, footprint_now());
+        kernel_footprint fp32, fp16, fp_packed;
         for (int size = step; size <= size_max; size += step) {
             cout << "\tsize " << size << "/" << size_max << endl;
             for (int threads = 1; threads <= threads_max; ++threads) {
                 cout << "\t\tthreads " << threads << "/" << threads_max << endl;
-                times[threads-1][size/step-1] += run(vec1, vec2, threads, size);
+                times[threads-1][size/step-1] += store.add("int32", size, threads, fp32.measure([&] {
+                    return run(vec1, vec2, threads, size);
+                }));
+                times16[threads-1][size/step-1] += store.add("int16", size, threads, fp16.measure([&] {
+                    return run(vec1_16, vec2_16, threads, size);
+                }));
+                times_packed[threads-1][size/step-1] += store.add("packed14", size, threads, fp_packed.measure([&] {
+                    return run_packed(vec1_packed, vec2_packed, threads, size);
+                }));
             }
         }
+        print_footprint("int32", fp32);
+        print_footprint("int16", fp16);
+        print_footprint("packed14", fp_packed);
     }
 
     cout << endl;
     std::cout << std::fixed;
     std::cout << std::setprecision(6);
-    for (const auto& thread : times) {
-        for (const auto time : thread) {
-            cout << time / iter_count << " ";
+    auto print_matrix = [iter_count](const vector<vector<double>> &matrix, const string &str) {
+        cout << str << endl;
+        for (const auto& thread : matrix) {
+            for (const auto time : thread) {
+                cout << time / iter_count << " ";
+            }
+            cout << endl;
+        }
+    };
+    print_matrix(times, "int32");
+    print_matrix(times16, "int16");
+    print_matrix(times_packed, "packed14");
+
+    // speedup over the whole size sweep for every thread count
+    cout << "speedup int16 / packed14 vs int32" << endl;
+    for (int threads = 1; threads <= threads_max; ++threads) {
+        double t32 = 0, t16 = 0, tp = 0;
+        for (int j = 0; j < times[threads-1].size(); ++j) {
+            t32 += times[threads-1][j];
+            t16 += times16[threads-1][j];
+            tp += times_packed[threads-1][j];
         }
-        cout << endl;
+        cout << threads << " " << t32 / t16 << " " << t32 / tp << endl;
     }
+    cout << "results " << store.save() << endl;
     return 0;
 }
 
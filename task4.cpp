@@ -3,6 +3,7 @@
 #include <omp.h>
 #include <iomanip>
 #include <algorithm>
+#include "results_store.h"
 
 using namespace std;
 
@@ -29,6 +30,7 @@ double run(const vector<vector<int>> &data, int threads, int size) {
 
 int main() {
     int threads_max = omp_get_max_threads();
+    results_store store("task4");
     vector times(threads_max, vector(100, 0.));
     int iter_count = 10;
     int size_max = 10'000;
@@ -49,7 +51,7 @@ int main() {
             cout << "\tsize " << size << "/" << size_max << endl;
             for (int threads = 1; threads <= threads_max; ++threads) {
                 cout << "\t\tthreads " << threads << "/" << threads_max << endl;
-                times[threads-1][size/step-1] += run(data, threads, size);
+                times[threads-1][size/step-1] += store.add("run", size, threads, run(data, threads, size));
             }
         }
     }
@@ -63,6 +65,7 @@ int main() {
         }
         cout << endl;
     }
+    cout << "results " << store.save() << endl;
     return 0;
 }
 
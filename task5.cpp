@@ -3,6 +3,7 @@
 #include <omp.h>
 #include <iomanip>
 #include <algorithm>
+#include "results_store.h"
 
 using namespace std;
 
@@ -27,6 +28,7 @@ double run(vector<vector<int>> &data, int threads, int size) {
 
 int main() {
     int threads_max = omp_get_max_threads();
+    results_store store("task5");
     vector times1(threads_max, 0.);
     vector times2(threads_max, 0.);
     int iter_count = 10;
@@ -69,8 +71,8 @@ int main() {
         }
         for (int threads = 1; threads <= threads_max; ++threads) {
             cout << "\t\tthreads " << threads << "/" << threads_max << endl;
-            times1[threads-1] += run(ref(triang), threads, size_max);
-            times2[threads-1] += run(ref(band), threads, size_max);
+            times1[threads-1] += store.add("triang", size_max, threads, run(ref(triang), threads, size_max));
+            times2[threads-1] += store.add("band", size_max, threads, run(ref(band), threads, size_max));
         }
     }
 
@@ -88,6 +90,7 @@ int main() {
         cout << i << " ";
     cout << endl;
 
+    cout << "results " << store.save() << endl;
     return 0;
 }
 
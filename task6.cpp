@@ -3,21 +3,28 @@
 #include <vector>
 #include <omp.h>
 #include <thread>
+#include <cstdint>
+#include "huge_pages.h"
+#include "results_store.h"
 
 using namespace std;
 
-double run_reduction(const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+using huge_vector = vector<int, huge_page_allocator<int>>;
+
+// T is the storage type, Acc the type the products are widened to
+template <typename T, typename Acc = int64_t, typename Alloc = allocator<T>>
+double run_reduction(const vector<T, Alloc> &vec1, const vector<T, Alloc> &vec2, int threads, int size) {
     double time = omp_get_wtime();
-    int res = 0;
+    Acc res = 0;
     omp_set_num_threads(threads);
-#pragma omp parallel for default(shared) reduction(+:res)
+#pragma omp parallel for simd default(shared) reduction(+:res)
     for (int i = 0; i < size; ++i)
-        res += vec1[i]*vec2[i];
+        res += (Acc) vec1[i] * (Acc) vec2[i];
 
     return omp_get_wtime() - time;
 }
 
-double run_atomic(const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+double run_atomic(const huge_vector &vec1, const huge_vector &vec2, int threads, int size) {
     double time = omp_get_wtime();
     int res = 0;
     omp_set_num_threads(threads);
@@ -29,7 +36,7 @@ double run_atomic(const vector<int> &vec1, const vector<int> &vec2, int threads,
     return omp_get_wtime() - time;
 }
 
-double run_lock(const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+double run_lock(const huge_vector &vec1, const huge_vector &vec2, int threads, int size) {
     double time = omp_get_wtime();
     int res = 0;
     omp_set_num_threads(threads);
@@ -44,7 +51,7 @@ double run_lock(const vector<int> &vec1, const vector<int> &vec2, int threads, i
     return omp_get_wtime() - time;
 }
 
-double run_lin(const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+double run_lin(const huge_vector &vec1, const huge_vector &vec2, int threads, int size) {
     double time = clock();
     int res = 0;
     omp_set_num_threads(threads);
@@ -54,7 +61,7 @@ double run_lin(const vector<int> &vec1, const vector<int> &vec2, int threads, in
     return (clock() - time) / 1000.;
 }
 
-double run_critical(const vector<int> &vec1, const vector<int> &vec2, int threads, int size) {
+double run_critical(const huge_vector &vec1, const huge_vector &vec2, int threads, int size) {
     double time = omp_get_wtime();
     int res = 0;
     omp_set_num_threads(threads);
@@ -68,38 +75,64 @@ double run_critical(const vector<int> &vec1, const vector<int> &vec2, int thread
 
 int main(int argc, char **argv) {
     int threads_max = omp_get_max_threads();
+    results_store store("task6");
     vector times_reduction(threads_max, 0.);
+    vector times_reduction16(threads_max, 0.);
     vector times_critical(threads_max, 0.);
     vector times_atomic(threads_max, 0.);
     vector times_lock(threads_max, 0.);
 
-    auto vector_generator = [](int size) {
-        vector data(1'000'000'000, 0);
+    // task6 [system|4k|thp|2m|1g] selects the page size backing the data
+    page_mode mode = parse_page_mode(argc > 1 ? argv[1] : "system");
+    auto vector_generator = [mode](int size) {
+        huge_vector data(1'000'000'000, 0, huge_page_allocator<int>(mode));
         for (auto &i: data)
             i = rand() % 10'000;
         return move(data);
     };
 
-    int iter_count = 1;
+    // compare needs at least 4 repetitions per side to find a significant change
+    int iter_count = 5;
     int size_max = 100'000'000;
 
     for (int i = 0; i < iter_count; ++i) {
         cout << "iter " << i +1 << "/" << iter_count << endl;
+        auto before_generator = footprint_now();
         auto vec1 = vector_generator(size_max);
         auto vec2 = vector_generator(size_max);
+        vector<int16_t, huge_page_allocator<int16_t>> vec1_16(vec1.begin(), vec1.begin() + size_max, huge_page_allocator<int16_t>(mode));
+        vector<int16_t, huge_page_allocator<int16_t>> vec2_16(vec2.begin(), vec2.begin() + size_max, huge_page_allocator<int16_t>(mode));
+        print_footprint("generator", before_generator, footprint_now());
+        kernel_footprint fp_atomic, fp_critical, fp_lock, fp_reduction, fp_reduction16;
         for (int threads = 1; threads <= threads_max; ++threads) {
             cout << "\tthreads " << threads << endl;
-            times_atomic[threads-1] += run_atomic(vec1, vec2, threads, size_max);
-            times_critical[threads-1] += run_critical(vec1, vec2, threads, size_max);
-            times_lock[threads-1] += run_lock(vec1, vec2, threads, size_max);
-            times_reduction[threads-1] += run_reduction(vec1, vec2, threads, size_max);
+            times_atomic[threads-1] += store.add("atomic", size_max, threads, fp_atomic.measure([&] {
+                return run_atomic(vec1, vec2, threads, size_max);
+            }));
+            times_critical[threads-1] += store.add("critical", size_max, threads, fp_critical.measure([&] {
+                return run_critical(vec1, vec2, threads, size_max);
+            }));
+            times_lock[threads-1] += store.add("lock", size_max, threads, fp_lock.measure([&] {
+                return run_lock(vec1, vec2, threads, size_max);
+            }));
+            times_reduction[threads-1] += store.add("reduction", size_max, threads, fp_reduction.measure([&] {
+                return run_reduction(vec1, vec2, threads, size_max);
+            }));
+            times_reduction16[threads-1] += store.add("reduction_int16", size_max, threads, fp_reduction16.measure([&] {
+                return run_reduction(vec1_16, vec2_16, threads, size_max);
+            }));
         }
+        print_footprint("atomic", fp_atomic);
+        print_footprint("critical", fp_critical);
+        print_footprint("lock", fp_lock);
+        print_footprint("reduction", fp_reduction);
+        print_footprint("reduction_int16", fp_reduction16);
     }
 
-    auto print_vec = [](const vector<double> &vec, const string& str) {
+    auto print_vec = [iter_count](const vector<double> &vec, const string& str) {
         cout << str << endl;
         for (auto i : vec)
-            cout << i << " ";
+            cout << i / iter_count << " ";
         cout << endl;
     };
     cout << endl;
@@ -107,10 +140,16 @@ int main(int argc, char **argv) {
     std::cout << std::setprecision(6);
 
     print_vec(times_reduction, "reduction");
+    print_vec(times_reduction16, "reduction int16");
+    cout << "reduction int16 speedup" << endl;
+    for (int i = 0; i < threads_max; ++i)
+        cout << times_reduction[i] / times_reduction16[i] << " ";
+    cout << endl;
     print_vec(times_atomic, "atomic");
     print_vec(times_critical, "critical");
     print_vec(times_lock, "lock");
 
+    cout << "results " << store.save() << endl;
     return 0;
 }
 
@@ -3,162 +3,286 @@
 #include <vector>
 #include <omp.h>
 #include <thread>
-#include <unordered_map>
-#include <functional>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include "results_store.h"
 
 using namespace std;
 
-double run_A(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename Body, size_t... U>
+inline void unroll_step(size_t k, Body &body, index_sequence<U...>) {
+    (body(k + U), ...);
+}
+
+// calls body(k) for k in [0, n), Unroll calls per step written out; a
+// compile time N that Unroll divides needs no remainder loop
+template <size_t Unroll, size_t N, typename Body>
+inline void unrolled(size_t n, Body body) {
+    if constexpr (N != 0 && N % Unroll == 0) {
+        for (size_t k = 0; k < N; k += Unroll)
+            unroll_step(k, body, make_index_sequence<Unroll>());
+    } else {
+        size_t k = 0;
+        for (; k + Unroll <= n; k += Unroll)
+            unroll_step(k, body, make_index_sequence<Unroll>());
+        for (; k < n; ++k)
+            body(k);
+    }
+}
+
+// sum of the last product; taken after the timer stops, it keeps the
+// compiler from dropping the kernels and lets main compare int and int16
+long long checksum = 0;
+
+template <typename Acc>
+void consume(const vector<vector<Acc>> &res) {
+    long long sum = 0;
+    for (const auto &row : res)
+        for (auto x : row)
+            sum += x;
+    checksum = sum;
+}
+
+// T is the storage type of the matrices, Acc the type products are widened to.
+// N != 0 fixes the matrix size at compile time, Unroll applies to a serial k loop
+template <typename T, typename Acc = int, size_t N = 0, size_t Unroll = 1>
+double run_A(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 #pragma omp parallel for default(shared)
-    for (int i = 0; i < m1.size(); ++i) {           // A
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                res[i][j] = m1[i][k] * m2[k][j];
-            }
+    for (size_t i = 0; i < n; ++i) {           // A
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
+            unrolled<Unroll, N>(n, [&](size_t k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
+            });
+            res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
-double run_B(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename T, typename Acc = int, size_t N = 0, size_t Unroll = 1>
+double run_B(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 
-    for (int i = 0; i < m1.size(); ++i) {           // A
+    for (size_t i = 0; i < n; ++i) {           // A
 #pragma omp parallel for default(shared)
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                res[i][j] = m1[i][k] * m2[k][j];
-            }
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
+            unrolled<Unroll, N>(n, [&](size_t k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
+            });
+            res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
-double run_C(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename T, typename Acc = int, size_t N = 0>
+double run_C(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 
-    for (int i = 0; i < m1.size(); ++i) {           // A
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            int curr = res[i][j];
+    for (size_t i = 0; i < n; ++i) {           // A
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
 #pragma omp parallel for default(shared) reduction(+:curr)
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                curr = m1[i][k] * m2[k][j];
+            for (size_t k = 0; k < n; ++k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
             }
             res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
-double run_AB(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename T, typename Acc = int, size_t N = 0, size_t Unroll = 1>
+double run_AB(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 #pragma omp parallel for default(shared)
-    for (int i = 0; i < m1.size(); ++i) {           // A
+    for (size_t i = 0; i < n; ++i) {           // A
 #pragma omp parallel for default(shared)
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                res[i][j] = m1[i][k] * m2[k][j];
-            }
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
+            unrolled<Unroll, N>(n, [&](size_t k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
+            });
+            res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
-double run_BC(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename T, typename Acc = int, size_t N = 0>
+double run_BC(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 
-    for (int i = 0; i < m1.size(); ++i) {           // A
+    for (size_t i = 0; i < n; ++i) {           // A
 #pragma omp parallel for default(shared)
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            int curr = res[i][j];
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
 #pragma omp parallel for default(shared) reduction(+:curr)
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                curr = m1[i][k] * m2[k][j];
+            for (size_t k = 0; k < n; ++k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
             }
             res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
-double run_AC(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename T, typename Acc = int, size_t N = 0>
+double run_AC(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 #pragma omp parallel for default(shared)
-    for (int i = 0; i < m1.size(); ++i) {           // A
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            int curr = res[i][j];
+    for (size_t i = 0; i < n; ++i) {           // A
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
 #pragma omp parallel for default(shared) reduction(+:curr)
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                curr = m1[i][k] * m2[k][j];
+            for (size_t k = 0; k < n; ++k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
             }
             res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
-double run_ABC(const vector<vector<int>> &m1, const vector<vector<int>> &m2, int threads) {
+template <typename T, typename Acc = int, size_t N = 0>
+double run_ABC(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
     double time = omp_get_wtime();
-    vector<vector<int>> res(m1.size(), vector<int>(m1.size()));
+    const size_t n = N ? N : m1.size();
+    vector<vector<Acc>> res(n, vector<Acc>(n));
     omp_set_num_threads(threads);
 
 #pragma omp parallel for default(shared)
-    for (int i = 0; i < m1.size(); ++i) {           // A
+    for (size_t i = 0; i < n; ++i) {           // A
 #pragma omp parallel for default(shared)
-        for (int j = 0; j < m1.size(); ++j) {       // B
-            int curr = res[i][j];
+        for (size_t j = 0; j < n; ++j) {       // B
+            Acc curr = res[i][j];
 #pragma omp parallel for default(shared) reduction(+:curr)
-            for (int k = 0; k < m1.size(); ++k) {   // C
-                curr = m1[i][k] * m2[k][j];
+            for (size_t k = 0; k < n; ++k) {   // C
+                curr += (Acc) m1[i][k] * m2[k][j];
             }
             res[i][j] = curr;
         }
     }
 
-    return omp_get_wtime() - time;
+    double elapsed = omp_get_wtime() - time;
+    consume(res);
+    return elapsed;
 }
 
+enum kernel_id { kernel_A, kernel_B, kernel_C, kernel_AB, kernel_BC, kernel_AC, kernel_ABC, kernel_count };
+const char *kernel_names[kernel_count] = {"A", "B", "C", "AB", "BC", "AC", "ABC"};
+
+// The k loop is bound by the column loads of m2. On 64x64 factors 1, 4
+// and 8 measured the same, unrolling all 64 iterations was 5x slower.
+const size_t kernel_unroll = 4;
+
+template <typename T>
+using kernel = double (*)(const vector<vector<T>> &, const vector<vector<T>> &, int);
+
+template <kernel_id K, typename T, size_t N>
+double run_kernel(const vector<vector<T>> &m1, const vector<vector<T>> &m2, int threads) {
+    if constexpr (K == kernel_A)
+        return run_A<T, int, N, kernel_unroll>(m1, m2, threads);
+    else if constexpr (K == kernel_B)
+        return run_B<T, int, N, kernel_unroll>(m1, m2, threads);
+    else if constexpr (K == kernel_C)
+        return run_C<T, int, N>(m1, m2, threads);
+    else if constexpr (K == kernel_AB)
+        return run_AB<T, int, N, kernel_unroll>(m1, m2, threads);
+    else if constexpr (K == kernel_BC)
+        return run_BC<T, int, N>(m1, m2, threads);
+    else if constexpr (K == kernel_AC)
+        return run_AC<T, int, N>(m1, m2, threads);
+    else
+        return run_ABC<T, int, N>(m1, m2, threads);
+}
+
+template <typename T, size_t K, size_t... Fixed>
+constexpr array<kernel<T>, sizeof...(Fixed) + 1> kernel_row() {
+    return {run_kernel<(kernel_id) K, T, 0>, run_kernel<(kernel_id) K, T, Fixed>...};
+}
+
+template <typename T, size_t... Fixed, size_t... K>
+constexpr array<array<kernel<T>, sizeof...(Fixed) + 1>, kernel_count> kernel_table(index_sequence<K...>) {
+    return {kernel_row<T, K, Fixed...>()...};
+}
+
+// Dispatch table for one element type, generated at compile time: row K
+// holds kernel K for runtime sizes in column 0 and one instantiation per
+// size in Fixed after it. The lookup happens once per run, the kernels
+// themselves contain no indirect calls.
+template <typename T, size_t... Fixed>
+struct kernel_registry {
+    static constexpr size_t sizes[] = {0, Fixed...};
+    static constexpr auto table = kernel_table<T, Fixed...>(make_index_sequence<kernel_count>());
+
+    static kernel<T> select(kernel_id k, size_t n) {
+        for (size_t c = 1; c < size(sizes); ++c)
+            if (sizes[c] == n)
+                return table[k][c];
+        return table[k][0];
+    }
+};
+
+// 16x16 to 64x64 blocks get instantiations with compile time bounds
+template <typename T>
+using registry = kernel_registry<T, 16, 32, 64>;
+
 int main(int argc, char **argv) {
     int threads_max = omp_get_max_threads();
-    unordered_map<string, function<double(const vector<vector<int>> &, const vector<vector<int>> &, int)>> funcs{
-            {"A",   run_A},
-            {"B",   run_B},
-            {"C",   run_C},
-            {"AB",  run_AB},
-            {"BC",  run_BC},
-            {"AC",  run_AC},
-            {"ABC", run_ABC}
-    };
+    results_store store("task9");
 
     int iter_count = 10;
-    int size_max = 1'000;
+    // the small size runs the specialized kernels, the large one the generic ones
+    vector<size_t> sizes{64, 1'000};
 
-    auto matr_generator = [](int size) {
+    auto matr_generator = [](size_t size) {
         vector data(size, vector(size, 0));
         for (auto &i: data)
             for (auto &j: i)
@@ -166,36 +290,65 @@ int main(int argc, char **argv) {
         return move(data);
     };
 
-    auto times = unordered_map<string, vector<double>> {
-            {"A",   vector<double>(threads_max)},
-            {"B",   vector<double>(threads_max)},
-            {"C",   vector<double>(threads_max)},
-            {"AB",  vector<double>(threads_max)},
-            {"BC",  vector<double>(threads_max)},
-            {"AC",  vector<double>(threads_max)},
-            {"ABC", vector<double>(threads_max)}
+    // size -> kernel -> threads
+    vector times(sizes.size(), vector(kernel_count, vector<double>(threads_max)));
+    // the same kernels over 16-bit storage, accumulating in int
+    auto times16 = times;
+
+    auto narrow = [](const vector<vector<int>> &m) {
+        vector<vector<int16_t>> data(m.size());
+        for (size_t i = 0; i < m.size(); ++i)
+            data[i].assign(m[i].begin(), m[i].end());
+        return data;
     };
 
     for (int i = 0; i < iter_count; ++i) {
-        auto m1 = matr_generator(size_max);
-        auto m2 = matr_generator(size_max);
-
-        for (int threads = 1; threads <= threads_max; ++threads) {
-            cout << "\tthreads " << threads << endl;
-            for (auto &[name, func] : funcs) {
-                cout << "\t\t" << name << endl;
-                times[name][threads-1] += func(m1, m2, threads);
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            size_t size = sizes[s];
+            cout << "size " << size << endl;
+            auto m1 = matr_generator(size);
+            auto m2 = matr_generator(size);
+            auto m1_16 = narrow(m1);
+            auto m2_16 = narrow(m2);
+
+            for (int threads = 1; threads <= threads_max; ++threads) {
+                cout << "\tthreads " << threads << endl;
+                for (size_t k = 0; k < kernel_count; ++k) {
+                    string name = kernel_names[k];
+                    cout << "\t\t" << name << endl;
+                    auto func = registry<int>::select((kernel_id) k, size);
+                    auto func16 = registry<int16_t>::select((kernel_id) k, size);
+                    times[s][k][threads-1] += store.add(name, size, threads, func(m1, m2, threads));
+                    long long expected = checksum;
+                    times16[s][k][threads-1] += store.add(name + "_int16", size, threads, func16(m1_16, m2_16, threads));
+                    if (checksum != expected)
+                        cout << "\t\t" << name << " int16 result differs" << endl;
+                }
             }
         }
     }
 
-    for (auto& [name, data] : times) {
-        cout << name << endl;
-        for (auto &el : data)
-            cout << el / iter_count << " ";
-        cout << endl;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        cout << "size " << sizes[s] << endl;
+        for (size_t k = 0; k < kernel_count; ++k) {
+            string name = kernel_names[k];
+            auto &data = times[s][k], &data16 = times16[s][k];
+            cout << name << endl;
+            for (auto &el : data)
+                cout << el / iter_count << " ";
+            cout << endl;
+            cout << name << " int16" << endl;
+            for (auto &el : data16)
+                cout << el / iter_count << " ";
+            cout << endl;
+            cout << name << " int16 speedup" << endl;
+            for (int i = 0; i < threads_max; ++i)
+                cout << data[i] / data16[i] << " ";
+            cout << endl;
+        }
     }
 
+    cout << "results " << store.save() << endl;
     return 0;
 }
 